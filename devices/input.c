@@ -1,15 +1,29 @@
 #include "devices/input.h"
 #include <debug.h>
-#include "devices/intq.h"
+#include "devices/ring.h"
 #include "devices/serial.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
 
-/* Stores keys from the keyboard and serial port. */
-static struct intq buffer;
+/* Stores keys from the keyboard and serial port.
+   The keyboard and serial interrupt handlers are the only
+   producers; readers are serialized by reader_lock, so the ring
+   has a single consumer as well and input_getc() only disables
+   interrupts when it has to sleep. */
+#define INPUT_BUFSIZE 64
+static uint8_t buffer_storage[INPUT_BUFSIZE];
+static struct ring buffer;
+static struct lock reader_lock;
+
+/* Reader sleeping until a key arrives, if any. */
+static struct thread *reader;
 
 /* Initializes the input buffer. */
 void input_init(void)
 {
-	intq_init(&buffer);
+	ring_init(&buffer, buffer_storage, sizeof buffer_storage);
+	lock_init(&reader_lock);
 }
 
 /* Adds a key to the input buffer.
@@ -17,9 +31,14 @@ void input_init(void)
 void input_putc(uint8_t key)
 {
 	ASSERT(intr_get_level() == INTR_OFF);
-	ASSERT(!intq_full(&buffer));
+	ASSERT(!ring_full(&buffer));
 
-	intq_putc(&buffer, key);
+	ring_put(&buffer, key);
+	if (reader != NULL)
+	{
+		thread_unblock(reader);
+		reader = NULL;
+	}
 	serial_notify();
 }
 
@@ -31,10 +50,29 @@ input_getc(void)
 	enum intr_level old_level;
 	uint8_t key;
 
-	old_level = intr_disable();
-	key = intq_getc(&buffer);
-	serial_notify();
-	intr_set_level(old_level);
+	lock_acquire(&reader_lock);
+	while (!ring_get(&buffer, &key))
+	{
+		/* Recheck with interrupts off, so that input_putc() cannot
+		   add a key between the check and thread_block(). */
+		old_level = intr_disable();
+		if (ring_empty(&buffer))
+		{
+			reader = thread_current();
+			thread_block();
+		}
+		intr_set_level(old_level);
+	}
+	lock_release(&reader_lock);
+
+	/* If the buffer was full, receive interrupts were turned off;
+	   now that there is room again, let the serial port resume. */
+	if (ring_space(&buffer) == 1)
+	{
+		old_level = intr_disable();
+		serial_notify();
+		intr_set_level(old_level);
+	}
 
 	return key;
 }
@@ -45,5 +83,5 @@ input_getc(void)
 bool input_full(void)
 {
 	ASSERT(intr_get_level() == INTR_OFF);
-	return intq_full(&buffer);
+	return ring_full(&buffer);
 }
@@ -0,0 +1,97 @@
+#include "devices/ring.h"
+#include <debug.h>
+#include <string.h>
+
+#define MIN(A, B) ((A) < (B) ? (A) : (B))
+
+/* Initializes R to use the SIZE bytes at BUF.
+   SIZE must be a power of two. */
+void
+ring_init (struct ring *r, void *buf, size_t size) {
+	ASSERT (buf != NULL);
+	ASSERT (size > 0 && (size & (size - 1)) == 0);
+
+	r->buf = buf;
+	r->mask = size - 1;
+	r->head = r->tail = 0;
+}
+
+/* Returns the number of bytes in R. */
+size_t
+ring_count (const struct ring *r) {
+	size_t tail = __atomic_load_n (&r->tail, __ATOMIC_ACQUIRE);
+	size_t head = __atomic_load_n (&r->head, __ATOMIC_ACQUIRE);
+	return head - tail;
+}
+
+/* Returns the number of bytes that can be put into R. */
+size_t
+ring_space (const struct ring *r) {
+	return r->mask + 1 - ring_count (r);
+}
+
+/* Returns true if R is empty, false otherwise. */
+bool
+ring_empty (const struct ring *r) {
+	return ring_count (r) == 0;
+}
+
+/* Returns true if R is full, false otherwise. */
+bool
+ring_full (const struct ring *r) {
+	return ring_space (r) == 0;
+}
+
+/* Adds BYTE to the end of R.  Returns false if R is full.
+   Producer only. */
+bool
+ring_put (struct ring *r, uint8_t byte) {
+	return ring_put_batch (r, &byte, 1) == 1;
+}
+
+/* Removes the first byte of R into *BYTE.  Returns false if R is
+   empty.  Consumer only. */
+bool
+ring_get (struct ring *r, uint8_t *byte) {
+	return ring_get_batch (r, byte, 1) == 1;
+}
+
+/* Adds up to N bytes from SRC to the end of R and returns the
+   number added, which is less than N only if R filled up.
+   Producer only. */
+size_t
+ring_put_batch (struct ring *r, const void *src_, size_t n) {
+	const uint8_t *src = src_;
+	size_t head = __atomic_load_n (&r->head, __ATOMIC_RELAXED);
+	size_t tail = __atomic_load_n (&r->tail, __ATOMIC_ACQUIRE);
+	size_t ofs = head & r->mask;
+	size_t first;
+
+	n = MIN (n, r->mask + 1 - (head - tail));
+	first = MIN (n, r->mask + 1 - ofs);
+	memcpy (r->buf + ofs, src, first);
+	memcpy (r->buf, src + first, n - first);
+
+	__atomic_store_n (&r->head, head + n, __ATOMIC_RELEASE);
+	return n;
+}
+
+/* Removes up to N bytes from the front of R into DST and returns
+   the number removed, which is less than N only if R ran empty.
+   Consumer only. */
+size_t
+ring_get_batch (struct ring *r, void *dst_, size_t n) {
+	uint8_t *dst = dst_;
+	size_t tail = __atomic_load_n (&r->tail, __ATOMIC_RELAXED);
+	size_t head = __atomic_load_n (&r->head, __ATOMIC_ACQUIRE);
+	size_t ofs = tail & r->mask;
+	size_t first;
+
+	n = MIN (n, head - tail);
+	first = MIN (n, r->mask + 1 - ofs);
+	memcpy (dst, r->buf + ofs, first);
+	memcpy (dst + first, r->buf, n - first);
+
+	__atomic_store_n (&r->tail, tail + n, __ATOMIC_RELEASE);
+	return n;
+}
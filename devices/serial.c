@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
 #include "devices/input.h"
-#include "devices/intq.h"
+#include "devices/ring.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -51,8 +51,20 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Data to be transmitted.
+   Bytes are put by serial_putbuf() and got by serial_interrupt()
+   and the polling paths, all with interrupts off. */
+#define TXQ_BUFSIZE 64
+static uint8_t txq_buf[TXQ_BUFSIZE];
+static struct ring txq;
+
+/* Threads waiting for room in txq.  Writers that bypass the
+   console lock, such as those racing a kernel panic, can wait at
+   the same time, so each waiter counts itself in txq_waiter_cnt
+   and downs txq_sema; serial_interrupt() ups it once per waiter
+   while there is room. */
+static struct semaphore txq_sema;
+static size_t txq_waiter_cnt;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
@@ -70,7 +82,8 @@ init_poll (void) {
 	outb (FCR_REG, 0);                    /* Disable FIFO. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	ring_init (&txq, txq_buf, sizeof txq_buf);
+	sema_init (&txq_sema, 0);
 	mode = POLL;
 }
 
@@ -95,28 +108,50 @@ serial_init_queue (void) {
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) {
+	serial_putbuf (&byte, 1);
+}
+
+/* Sends the N bytes in BUFFER to the serial port.
+   Interrupts are disabled once for the whole buffer, which is
+   queued in as few batches as the free space allows. */
+void
+serial_putbuf (const void *buffer, size_t n) {
+	const uint8_t *buf = buffer;
 	enum intr_level old_level = intr_disable ();
 
 	if (mode != QUEUE) {
 		/* If we're not set up for interrupt-driven I/O yet,
-		   use dumb polling to transmit a byte. */
+		   use dumb polling to transmit the bytes. */
 		if (mode == UNINIT)
 			init_poll ();
-		putc_poll (byte);
+		while (n-- > 0)
+			putc_poll (*buf++);
 	} else {
-		/* Otherwise, queue a byte and update the interrupt enable
-		   register. */
-		if (old_level == INTR_OFF && intq_full (&txq)) {
-			/* Interrupts are off and the transmit queue is full.
-			   If we wanted to wait for the queue to empty,
-			   we'd have to reenable interrupts.
-			   That's impolite, so we'll send a character via
-			   polling instead. */
-			putc_poll (intq_getc (&txq));
+		/* Otherwise, queue the bytes and update the interrupt
+		   enable register. */
+		for (;;) {
+			size_t cnt = ring_put_batch (&txq, buf, n);
+			buf += cnt;
+			n -= cnt;
+			write_ier ();
+			if (n == 0)
+				break;
+
+			if (old_level == INTR_OFF) {
+				/* Interrupts are off and the transmit queue is full.
+				   If we wanted to wait for the queue to empty,
+				   we'd have to reenable interrupts.
+				   That's impolite, so we'll send a character via
+				   polling instead. */
+				uint8_t byte;
+				ring_get (&txq, &byte);
+				putc_poll (byte);
+			} else {
+				/* Wait for serial_interrupt() to make room. */
+				txq_waiter_cnt++;
+				sema_down (&txq_sema);
+			}
 		}
-
-		intq_putc (&txq, byte);
-		write_ier ();
 	}
 
 	intr_set_level (old_level);
@@ -127,8 +162,10 @@ serial_putc (uint8_t byte) {
 void
 serial_flush (void) {
 	enum intr_level old_level = intr_disable ();
-	while (!intq_empty (&txq))
-		putc_poll (intq_getc (&txq));
+	uint8_t byte;
+
+	while (ring_get (&txq, &byte))
+		putc_poll (byte);
 	intr_set_level (old_level);
 }
 
@@ -171,7 +208,7 @@ write_ier (void) {
 
 	/* Enable transmit interrupt if we have any characters to
 	   transmit. */
-	if (!intq_empty (&txq))
+	if (!ring_empty (&txq))
 		ier |= IER_XMIT;
 
 	/* Enable receive interrupt if we have room to store any
@@ -196,6 +233,8 @@ putc_poll (uint8_t byte) {
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) {
+	uint8_t byte;
+
 	/* Inquire about interrupt in UART.  Without this, we can
 	   occasionally miss an interrupt running under QEMU. */
 	inb (IIR_REG);
@@ -207,8 +246,15 @@ serial_interrupt (struct intr_frame *f UNUSED) {
 
 	/* As long as we have a byte to transmit, and the hardware is
 	   ready to accept a byte for transmission, transmit a byte. */
-	while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
-		outb (THR_REG, intq_getc (&txq));
+	while ((inb (LSR_REG) & LSR_THRE) != 0 && ring_get (&txq, &byte))
+		outb (THR_REG, byte);
+
+	/* Let a writer waiting for room continue.  It queues more
+	   bytes, so the next transmit interrupt wakes the one after. */
+	if (txq_waiter_cnt > 0 && !ring_full (&txq)) {
+		txq_waiter_cnt--;
+		sema_up (&txq_sema);
+	}
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier ();
@@ -4,4 +4,4 @@ devices_SRC += devices/vga.c		# Video device.
 devices_SRC += devices/serial.c		# Serial port device.
 devices_SRC += devices/disk.c		# IDE disk device.
 devices_SRC += devices/input.c		# Serial and keyboard input.
-devices_SRC += devices/intq.c		# Interrupt queue.
+devices_SRC += devices/ring.c		# SPSC byte ring.
@@ -17,8 +17,28 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
-/* Number of timer ticks since OS booted. */
+/* 8254 input frequency divided by TIMER_FREQ, rounded to
+   nearest.  This is the PIT count for one timer tick. */
+#define PIT_TICK_COUNT ((1193180 + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Largest number of ticks that fits in the 16-bit PIT counter. */
+#define TICKLESS_MAX_TICKS (0xffff / PIT_TICK_COUNT)
+
+/* Number of timer ticks since OS booted.
+   Written only with ticks_seq held; see timer_ticks(). */
 static int64_t ticks;
+static struct seqlock ticks_seq;
+
+/* -tickless: Stop the periodic tick while the idle thread halts?
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* Number of ticks the next timer interrupt accounts for while
+   the PIT is in one-shot mode, or 0 while it is running
+   periodically.  timer_idle_enter() sets it to the (at least 2)
+   ticks it lets the CPU sleep; timer_idle_exit() sets it to 1
+   while the PIT counts out the rest of a partial tick. */
+static int64_t oneshot_ticks;
 
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
@@ -28,20 +48,17 @@ static intr_handler_func timer_interrupt;
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
+static void pit_set_periodic(void);
+static void pit_set_oneshot(uint16_t count);
+static void ticks_advance(int64_t n);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void timer_init(void)
 {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb(0x40, count & 0xff);
-	outb(0x40, count >> 8);
-
+	seqlock_init(&ticks_seq);
+	pit_set_periodic();
 	intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -75,13 +92,29 @@ void timer_calibrate(void)
 int64_t
 timer_ticks(void)
 {
-	enum intr_level old_level = intr_disable();
-	int64_t t = ticks;
-	intr_set_level(old_level);
+	unsigned seq;
+	int64_t t;
+
+	/* ticks is 64 bits wide; retry instead of disabling
+	   interrupts if the timer interrupt updated it meanwhile. */
+	do
+	{
+		seq = read_seqbegin(&ticks_seq);
+		t = ticks;
+	} while (read_seqretry(&ticks_seq, seq));
 	barrier();
 	return t;
 }
 
+/* Advances the tick counter by N. */
+static void
+ticks_advance(int64_t n)
+{
+	write_seqlock(&ticks_seq);
+	ticks += n;
+	write_sequnlock(&ticks_seq);
+}
+
 /* Returns the number of timer ticks elapsed since THEN, which
    should be a value once returned by timer_ticks(). */
 int64_t
@@ -126,18 +159,93 @@ void timer_sleep(int64_t ticks)
 	thread_sleep(start + ticks); // 일어날 시간
 }
 
+/* Called by the idle thread, with interrupts off, just before it
+   halts the CPU.  In tickless mode, reprograms the PIT to fire
+   once at the next sleeping thread's wakeup tick instead of at
+   every tick.
+
+   The MLFQS scheduler needs its per-tick and per-second
+   bookkeeping, so the tick is never stopped when it is active. */
+void timer_idle_enter(void)
+{
+	int64_t delta;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (!timer_tickless || thread_mlfqs || oneshot_ticks != 0)
+		return;
+
+	delta = get_next_tick_to_awake() - ticks;
+	if (delta > TICKLESS_MAX_TICKS)
+		delta = TICKLESS_MAX_TICKS;
+	if (delta <= 1)
+		return;
+
+	oneshot_ticks = delta;
+	pit_set_oneshot(delta * PIT_TICK_COUNT);
+}
+
+/* Called on entry to every external interrupt other than the
+   timer's own, before its handler can wake a thread.  If the CPU
+   was idling in tickless mode, reads how far the PIT has counted,
+   replays the whole ticks that elapsed through thread_tick(), and
+   arms a one-shot for the rest of the current tick; the timer
+   interrupt at its end restores the periodic tick, so no partial
+   tick is lost. */
+void timer_idle_exit(void)
+{
+	int64_t programmed, remaining, elapsed;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(intr_context());
+
+	/* Periodic, or already finishing a partial tick. */
+	if (oneshot_ticks <= 1)
+		return;
+
+	outb(0x43, 0x00); /* CW: latch counter 0. */
+	remaining = inb(0x40);
+	remaining |= inb(0x40) << 8;
+
+	/* The counter already wrapped, so the timer interrupt is
+	   pending and will do the catch-up itself. */
+	programmed = oneshot_ticks * PIT_TICK_COUNT;
+	if (remaining > programmed)
+		return;
+
+	elapsed = programmed - remaining;
+	oneshot_ticks = 1;
+	pit_set_oneshot(PIT_TICK_COUNT - elapsed % PIT_TICK_COUNT);
+
+	for (elapsed /= PIT_TICK_COUNT; elapsed > 0; elapsed--)
+	{
+		ticks_advance(1);
+		thread_tick();
+	}
+	if (get_next_tick_to_awake() <= ticks)
+		thread_awake(ticks);
+}
+
 /* Timer interrupt handler. */
 /* 매 tick마다 타이머 인터럽트 시 호출되는 함수 */
 static void
 timer_interrupt(struct intr_frame *args UNUSED)
 {
-	ticks++;
-	thread_tick();
+	/* One-shot deadline set by timer_idle_enter() or
+	   timer_idle_exit() expired.  Account for the ticks the idle
+	   thread slept through. */
+	if (oneshot_ticks != 0)
+	{
+		pit_set_periodic();
+		for (; oneshot_ticks > 1; oneshot_ticks--)
+		{
+			ticks_advance(1);
+			thread_tick();
+		}
+		oneshot_ticks = 0;
+	}
 
-	// 가장 빨리 깨어날 스레드 tick값 확인
-	// 깰 시간 지난 스레드 있으면 깨움
-	// 스레드의 wakeup이랑 현재시간 비교
-	// if (get_next_tick_to_awake() <= ticks)
+	ticks_advance(1);
+	thread_tick();
 
 	/* To do implement advanced scheduler
 	 * 1초 마다 load_avg, 모든 스레드의 recent_cpu, priority 재계산
@@ -146,8 +254,9 @@ timer_interrupt(struct intr_frame *args UNUSED)
 
 	/*
 	 * mlfqs 스케줄러일 경우 timer_interrupt가 발생할때 마다 recent_cpu 1 증가
-	 * 1초마다 loag_avg, recent_cpu, priority 계산
-	 * 매 4tick마다 priority 계산
+	 * 1초마다 loag_avg 계산, 새 recent_cpu epoch 시작
+	 * 매 4tick마다 현재 스레드의 priority 계산
+	 * 새 epoch의 ready 스레드는 tick마다 몇 개씩 나눠서 갱신 (tick당 상수 시간)
 	 */
 	if (thread_mlfqs)
 	{
@@ -161,11 +270,36 @@ timer_interrupt(struct intr_frame *args UNUSED)
 		{
 			mlfqs_recalc_priority();
 		}
-		thread_awake(ticks);
-		return;
+		mlfqs_refresh_ready();
 	}
 
-	thread_awake(ticks);
+	// 가장 빨리 깨어날 스레드 tick값 확인
+	// 깰 시간 지난 스레드 있으면 깨움
+	// 스레드의 wakeup이랑 현재시간 비교
+	if (get_next_tick_to_awake() <= ticks)
+		thread_awake(ticks);
+}
+
+/* Programs PIT counter 0 to interrupt TIMER_FREQ times per
+   second. */
+static void
+pit_set_periodic(void)
+{
+	uint16_t count = PIT_TICK_COUNT;
+
+	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb(0x40, count & 0xff);
+	outb(0x40, count >> 8);
+}
+
+/* Programs PIT counter 0 to interrupt once after COUNT input
+   clocks. */
+static void
+pit_set_oneshot(uint16_t count)
+{
+	outb(0x43, 0x30); /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb(0x40, count & 0xff);
+	outb(0x40, count >> 8);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
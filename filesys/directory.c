@@ -5,6 +5,7 @@
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir
@@ -21,6 +22,18 @@ struct dir_entry
 	bool in_use;				/* In use or free? */
 };
 
+/* Protects the entries of every directory.  Lookups and readdir
+ * far outnumber dir_add() and dir_remove(), so they share it and
+ * only changes take it exclusively.  The file system has a single
+ * (root) directory, so one lock costs no parallelism. */
+static struct rwlock dir_rw;
+
+/* Initializes the directory module. */
+void dir_init(void)
+{
+	rw_init(&dir_rw);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool dir_create(disk_sector_t sector, size_t entry_cnt)
@@ -121,10 +134,12 @@ bool dir_lookup(const struct dir *dir, const char *name,
 	ASSERT(dir != NULL);
 	ASSERT(name != NULL);
 
+	rw_read_acquire(&dir_rw);
 	if (lookup(dir, name, &e, NULL))
 		*inode = inode_open(e.inode_sector);
 	else
 		*inode = NULL;
+	rw_read_release(&dir_rw);
 
 	return *inode != NULL;
 }
@@ -148,6 +163,8 @@ bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector)
 	if (*name == '\0' || strlen(name) > NAME_MAX)
 		return false;
 
+	rw_write_acquire(&dir_rw);
+
 	/* Check that NAME is not in use. */
 	if (lookup(dir, name, NULL, NULL))
 		goto done;
@@ -171,6 +188,7 @@ bool dir_add(struct dir *dir, const char *name, disk_sector_t inode_sector)
 	success = inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
 
 done:
+	rw_write_release(&dir_rw);
 	return success;
 }
 
@@ -187,6 +205,8 @@ bool dir_remove(struct dir *dir, const char *name)
 	ASSERT(dir != NULL);
 	ASSERT(name != NULL);
 
+	rw_write_acquire(&dir_rw);
+
 	/* Find directory entry. */
 	if (!lookup(dir, name, &e, &ofs))
 		goto done;
@@ -206,6 +226,7 @@ bool dir_remove(struct dir *dir, const char *name)
 	success = true;
 
 done:
+	rw_write_release(&dir_rw);
 	inode_close(inode);
 	return success;
 }
@@ -216,15 +237,19 @@ done:
 bool dir_readdir(struct dir *dir, char name[NAME_MAX + 1])
 {
 	struct dir_entry e;
+	bool found = false;
 
+	rw_read_acquire(&dir_rw);
 	while (inode_read_at(dir->inode, &e, sizeof e, dir->pos) == sizeof e)
 	{
 		dir->pos += sizeof e;
 		if (e.in_use)
 		{
 			strlcpy(name, e.name, NAME_MAX + 1);
-			return true;
+			found = true;
+			break;
 		}
 	}
-	return false;
+	rw_read_release(&dir_rw);
+	return found;
 }
@@ -6,6 +6,9 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/rcu.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -34,6 +37,7 @@ struct inode {
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* Inode content. */
+	struct rcu_head rcu;                /* Deferred free after close. */
 };
 
 /* Returns the disk sector that contains byte offset POS within
@@ -50,13 +54,60 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 }
 
 /* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
+ * returns the same `struct inode'.
+ * Lookups walk the list under rcu_read_lock() only; insertion and
+ * removal take open_inodes_lock, and a closed inode is freed after
+ * an RCU grace period so that a concurrent lookup never touches
+ * freed memory. */
 static struct list open_inodes;
+static struct lock open_inodes_lock;
+
+/* In-memory inodes come from their own object cache: with the
+ * 512-byte inode_disk inside, malloc() would round each one up
+ * to 1 kB. */
+static struct kmem_cache *inode_slab;
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	lock_init (&open_inodes_lock);
+	inode_slab = kmem_cache_create ("inode", sizeof (struct inode), NULL);
+	if (inode_slab == NULL)
+		PANIC ("inode_init: cannot create object cache");
+}
+
+/* Takes a reference to INODE unless its last opener has already
+ * dropped it, in which case it is on its way out of open_inodes. */
+static bool
+inode_get_unless_zero (struct inode *inode) {
+	int cnt = __atomic_load_n (&inode->open_cnt, __ATOMIC_RELAXED);
+	while (cnt != 0)
+		if (__atomic_compare_exchange_n (&inode->open_cnt, &cnt, cnt + 1,
+					false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return true;
+	return false;
+}
+
+/* Returns the live open inode for SECTOR with a new reference
+ * taken, or a null pointer.  The caller must be in an RCU read
+ * section or hold open_inodes_lock. */
+static struct inode *
+open_inodes_find (disk_sector_t sector) {
+	struct list_elem *e;
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+		if (inode->sector == sector && inode_get_unless_zero (inode))
+			return inode;
+	}
+	return NULL;
+}
+
+static void
+inode_free_rcu (struct rcu_head *head) {
+	kmem_cache_free (inode_slab, (uint8_t *) head - offsetof (struct inode, rcu));
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,31 +152,40 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode *inode, *dup;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	rcu_read_lock ();
+	inode = open_inodes_find (sector);
+	rcu_read_unlock ();
+	if (inode != NULL)
+		return inode;
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = kmem_cache_alloc (inode_slab);
 	if (inode == NULL)
 		return NULL;
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize fully before publishing it to lock-free readers. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
 	disk_read (filesys_disk, inode->sector, &inode->data);
+
+	/* Someone may have opened it while we were reading. */
+	lock_acquire (&open_inodes_lock);
+	dup = open_inodes_find (sector);
+	if (dup == NULL) {
+		__atomic_thread_fence (__ATOMIC_RELEASE);
+		list_push_front (&open_inodes, &inode->elem);
+	}
+	lock_release (&open_inodes_lock);
+
+	if (dup != NULL) {
+		kmem_cache_free (inode_slab, inode);
+		return dup;
+	}
 	return inode;
 }
 
@@ -133,7 +193,7 @@ inode_open (disk_sector_t sector) {
 struct inode *
 inode_reopen (struct inode *inode) {
 	if (inode != NULL)
-		inode->open_cnt++;
+		__atomic_fetch_add (&inode->open_cnt, 1, __ATOMIC_RELAXED);
 	return inode;
 }
 
@@ -153,9 +213,12 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
+	if (__atomic_sub_fetch (&inode->open_cnt, 1, __ATOMIC_ACQ_REL) == 0) {
+		/* Remove from inode list.  Readers may still be looking at
+		 * it; list_remove() leaves its links intact for them. */
+		lock_acquire (&open_inodes_lock);
 		list_remove (&inode->elem);
+		lock_release (&open_inodes_lock);
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
@@ -164,7 +227,7 @@ inode_close (struct inode *inode) {
 					bytes_to_sectors (inode->data.length)); 
 		}
 
-		free (inode); 
+		call_rcu (&inode->rcu, inode_free_rcu);
 	}
 }
 
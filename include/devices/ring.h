@@ -0,0 +1,39 @@
+#ifndef DEVICES_RING_H
+#define DEVICES_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A lock-free single-producer, single-consumer ring of bytes,
+   shared between kernel threads and interrupt handlers.
+
+   One context may put bytes while one other context gets them,
+   without locks and without disabling interrupts.  Only the
+   producer writes HEAD and only the consumer writes TAIL; each
+   side fills or drains the buffer first and then publishes its
+   index with a release store, which the other side reads with an
+   acquire load.  If a ring can have more than one producer or
+   more than one consumer, the caller must serialize them.
+
+   HEAD and TAIL count bytes ever put and got; they are reduced
+   modulo the buffer size, which must be a power of two, only when
+   indexing BUF. */
+struct ring {
+	uint8_t *buf;               /* Storage supplied by the owner. */
+	size_t mask;                /* Buffer size minus 1. */
+	size_t head;                /* Bytes put so far (producer). */
+	size_t tail;                /* Bytes got so far (consumer). */
+};
+
+void ring_init (struct ring *, void *buf, size_t size);
+size_t ring_count (const struct ring *);
+size_t ring_space (const struct ring *);
+bool ring_empty (const struct ring *);
+bool ring_full (const struct ring *);
+bool ring_put (struct ring *, uint8_t);
+bool ring_get (struct ring *, uint8_t *);
+size_t ring_put_batch (struct ring *, const void *, size_t);
+size_t ring_get_batch (struct ring *, void *, size_t);
+
+#endif /* devices/ring.h */
@@ -0,0 +1,48 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <list.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Maximum number of CPUs. */
+#define NCPU_MAX 8
+
+/* Per-CPU data area.
+
+   Each CPU schedules threads from its own run queue: one FIFO
+   list per priority level, PRI_MIN through PRI_MAX, with bit N
+   of ready_mask set iff ready_list[N] is nonempty.  Other CPUs
+   may push threads onto a run queue, so it is protected by
+   rq_lock rather than by just disabling interrupts. */
+struct cpu
+{
+	int id;								 /* Index into cpus[]. */
+	struct spinlock rq_lock;			 /* Protects the run queue. */
+	struct list ready_list[PRI_MAX + 1]; /* Ready threads, per priority. */
+	uint64_t ready_mask;				 /* Nonempty ready_list levels. */
+	int ready_cnt;						 /* # of threads in ready_list. */
+	struct thread *idle_thread;			 /* Runs when ready_list is empty. */
+	unsigned thread_ticks;				 /* # of timer ticks since last yield. */
+	unsigned long long rcu_qs;			 /* # of context switches, see rcu.c. */
+	int refresh_pri;					 /* Next level for mlfqs_refresh_ready(), or -1. */
+
+	/* Statistics. */
+	long long idle_ticks;	/* # of timer ticks spent idle. */
+	long long kernel_ticks; /* # of timer ticks in kernel threads. */
+	long long user_ticks;	/* # of timer ticks in user programs. */
+};
+
+/* All CPUs, of which the first CPU_CNT are online.
+   cpus[0] is the bootstrap processor.  Application processors
+   are not started (there is no local APIC or AP trampoline
+   support yet), so only the bootstrap processor runs threads and
+   CPU_CNT is 1.  This per-CPU split is groundwork that keeps the
+   scheduler's state in one place for when they are. */
+extern struct cpu cpus[NCPU_MAX];
+extern int cpu_cnt;
+
+struct cpu *this_cpu (void);
+
+#endif /* threads/cpu.h */
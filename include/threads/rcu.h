@@ -0,0 +1,42 @@
+#ifndef THREADS_RCU_H
+#define THREADS_RCU_H
+
+#include <list.h>
+
+/* Read-copy-update.
+
+   Readers bracket their traversal of an RCU-protected structure
+   with rcu_read_lock() and rcu_read_unlock() and take no lock.
+   A read-side critical section must not sleep; it is not
+   preempted either, by the timer or by a higher-priority thread
+   woken from an interrupt handler, so a context switch on a CPU
+   means that CPU has left any read section it was in (a
+   quiescent state).
+
+   Writers still serialize among themselves with an ordinary
+   lock.  After unlinking an object they must not free it until
+   every CPU has passed through a quiescent state (a grace
+   period): either wait with synchronize_rcu() or hand the object
+   to call_rcu(), which runs FUNC from the reaper thread once a
+   grace period has elapsed.  FUNC runs with interrupts on and may
+   sleep, e.g. on the lock of the allocator it frees to. */
+
+/* Embedded in an object whose reclamation is deferred. */
+struct rcu_head
+{
+	struct list_elem elem;				/* Element in callback list. */
+	void (*func) (struct rcu_head *);	/* Called after a grace period. */
+};
+
+void rcu_init (void);
+
+void rcu_read_lock (void);
+void rcu_read_unlock (void);
+
+void synchronize_rcu (void);
+void call_rcu (struct rcu_head *, void (*func) (struct rcu_head *));
+
+bool rcu_callbacks_pending (void);
+void rcu_process_callbacks (void);
+
+#endif /* threads/rcu.h */
@@ -0,0 +1,18 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches ("slab allocator") for fixed-size kernel objects.
+   See slab.c. */
+struct kmem_cache;
+
+void slab_init (void);
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		void (*ctor) (void *));
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+struct kmem_cache *kmem_cache_of (const void *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
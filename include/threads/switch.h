@@ -0,0 +1,28 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#include <stdint.h>
+
+/* switch_threads()'s stack frame.
+ * Only the registers that the System V ABI makes callee-saved
+ * are kept here; everything else is already dead across the call.
+ * Must match the push/pop order in switch.S. */
+struct switch_threads_frame {
+	uint64_t r15;
+	uint64_t r14;          /* switch_entry: kernel_thread() itself. */
+	uint64_t r13;          /* switch_entry: AUX for kernel_thread(). */
+	uint64_t r12;          /* switch_entry: FUNCTION for kernel_thread(). */
+	uint64_t rbp;
+	uint64_t rbx;
+	void (*rip) (void);    /* Return address. */
+};
+
+/* Saves the current thread's callee-saved registers on its stack,
+ * stores the stack pointer into *CUR_RSP, and resumes the thread
+ * whose stack pointer is NEXT_RSP. */
+void switch_threads (uint64_t *cur_rsp, uint64_t next_rsp);
+
+/* First code run by a newly created thread. */
+void switch_entry (void);
+
+#endif /* threads/switch.h */
@@ -3,31 +3,79 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
 
-/* A counting semaphore. */
+/* A counting semaphore.
+   If the thread expected to up it is known, sema_set_owner()
+   records it as OWNER, and waiters donate their priority to it
+   the same way lock waiters donate to the holder. */
 struct semaphore {
 	unsigned value;             /* Current value. */
 	struct list waiters;        /* List of waiting threads. */
+	struct thread *owner;       /* Thread expected to up it, or NULL. */
+	struct list_elem owner_elem; /* Element in owner's owned_semas. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
+void sema_set_owner (struct semaphore *, struct thread *);
+int sema_donated_priority (struct thread *);
 void sema_self_test (void);
 
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct list_elem elem;      /* Element in holder's held_locks. */
+	int max_priority;           /* Highest priority among waiters. */
+#ifdef LOCK_PROFILE
+	struct lock_site *site;     /* Statistics of the lock_init() site. */
+	int64_t acquired_at;        /* Tick at which holder got the lock. */
+#endif
 };
 
 void lock_init (struct lock *);
+
+#ifdef LOCK_PROFILE
+/* Contention statistics, shared by all locks initialized at the
+   same lock_init() call site. */
+struct lock_site {
+	const char *file;           /* Source file of the lock_init() call. */
+	int line;                   /* Line of the lock_init() call. */
+	unsigned long long acquires;  /* Successful acquisitions. */
+	unsigned long long contended; /* Acquisitions that had to wait. */
+	int64_t wait_ticks;         /* Total ticks spent waiting. */
+	int64_t max_hold_ticks;     /* Longest time a lock was held. */
+};
+
+void lock_init_at (struct lock *, const char *file, int line);
+#define lock_init(LOCK) lock_init_at ((LOCK), __FILE__, __LINE__)
+void lock_print_stats (void);
+#endif
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Adaptive mutex.  A lock that first spins for a while if its
+   holder is running on another CPU, and only then blocks through
+   the underlying lock (with priority donation). */
+struct mutex {
+	struct lock lock;           /* Underlying sleeping lock. */
+};
+
+void mutex_init (struct mutex *);
+void mutex_acquire (struct mutex *);
+bool mutex_try_acquire (struct mutex *);
+void mutex_release (struct mutex *);
+bool mutex_held_by_current_thread (const struct mutex *);
+#ifdef LOCK_PROFILE
+#define mutex_init(MUTEX) lock_init_at (&(MUTEX)->lock, __FILE__, __LINE__)
+#endif
+
 /* Condition variable. */
 struct condition {
 	struct list waiters;        /* List of waiting threads. */
@@ -38,7 +86,69 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock.
+   Any number of readers or a single writer may hold it.  Writers
+   are preferred: once a writer is waiting, new readers block, so
+   a steady stream of readers cannot starve writers.  Blocked
+   threads donate their priority to every current holder. */
+struct rwlock {
+	int readers;                /* # of threads holding it shared. */
+	struct thread *writer;      /* Thread holding it exclusive, or NULL. */
+	struct list holders;        /* rw_hold of every current holder. */
+	struct list read_waiters;   /* Threads blocked in rw_read_acquire(). */
+	struct list write_waiters;  /* Threads blocked in rw_write_acquire(). */
+};
+
+/* Records that a thread holds an rwlock, so that waiters can
+   find every holder to donate to.  Each thread has RW_HOLD_MAX
+   of these, so a thread may hold at most that many rwlocks at
+   once; acquiring one more fails an assertion. */
+#define RW_HOLD_MAX 4
+struct rw_hold {
+	struct rwlock *lock;        /* Held rwlock, or NULL if unused. */
+	struct thread *thread;      /* Holding thread. */
+	struct list_elem elem;      /* Element in lock's holders list. */
+};
+
+void rw_init (struct rwlock *);
+void rw_read_acquire (struct rwlock *);
+void rw_read_release (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_write_release (struct rwlock *);
+bool rw_write_held_by_current_thread (const struct rwlock *);
+int rw_donated_priority (struct thread *);
+
+/* Spin lock.  Busy-waits instead of sleeping, so it may be
+   taken inside the scheduler and in interrupt handlers.
+   Interrupts stay disabled on the local CPU while it is held. */
+struct spinlock {
+	volatile int locked;        /* Nonzero while held. */
+	enum intr_level old_level;  /* Interrupt level before acquiring. */
+};
+
+void spin_lock_init (struct spinlock *);
+void spin_lock (struct spinlock *);
+void spin_unlock (struct spinlock *);
+
+/* Sequence lock, for small values that are read far more often
+   than written.  Readers never block or disable interrupts: they
+   read the values between read_seqbegin() and read_seqretry() and
+   retry if a writer ran meanwhile.  Writers are serialized by a
+   spin lock, so they may run in interrupt handlers.  A reader must
+   not run inside a write section on the same CPU. */
+struct seqlock {
+	unsigned seq;               /* Odd while a write is in progress. */
+	struct spinlock lock;       /* Serializes writers. */
+};
+
+void seqlock_init (struct seqlock *);
+unsigned read_seqbegin (const struct seqlock *);
+bool read_seqretry (const struct seqlock *, unsigned start);
+void write_seqlock (struct seqlock *);
+void write_sequnlock (struct seqlock *);
+
 bool cmp_sem_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
+void sema_waiter_reposition(struct thread *);
 
 /* Optimization barrier.
  *
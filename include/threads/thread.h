@@ -11,6 +11,8 @@
 #include "vm/vm.h"
 #endif
 
+struct cpu;
+
 /* States in a thread's life cycle. */
 enum thread_status
 {
@@ -30,6 +32,12 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63	   /* Highest priority. */
 
+/* Maximum length of a donation chain that is followed. */
+#define DONATION_DEPTH_MAX 8
+
+/* Largest (nicest) nice value. */
+#define NICE_MAX 20
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -98,14 +106,23 @@ struct thread
 
 	int init_priority;		   /* donation 이후 우선순위를 초기화하기 위해 초기값 저장 */
 	struct lock *wait_on_lock; /* 해당 스레드가 대기하고있는 lock자료구조의 주소를 저장 */
-	struct list donations;	   /* 해당 스레드가 우선순위는 낮으나 lock을 보유하고 있을 때 사용됨 */
-	struct list_elem d_elem;   /* 낮은 우선순위를 가진 스레드의 donations가 가리키는 list_elem  */
+	struct semaphore *waiting_sema;	 /* block 되어 대기 중인 semaphore */
+	struct condition *waiting_cond;	 /* 대기 중인 condition variable */
+	struct list_elem *cond_elem;	 /* waiting_cond->waiters 안의 semaphore_elem */
+	struct list held_locks;	   /* 보유 중인 lock 목록 (lock의 max_priority 내림차순) */
+	struct list owned_semas;   /* owner로 등록된 semaphore 목록 (semaphore donation 용) */
+	struct rw_hold rw_holds[RW_HOLD_MAX]; /* 보유 중인 rwlock 기록 (rwlock donation 용) */
+	struct rwlock *waiting_rw;	 /* block 되어 대기 중인 rwlock */
+	struct cpu *cpu;		   /* CPU running this thread or holding it in its run queue. */
+	int rcu_nesting;		   /* RCU read-side critical section 깊이 */
+	bool rcu_yield_deferred;   /* read section 안에서 미뤄진 선점 */
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;	  /* List element. */
 	struct list_elem allelem; /* advanced scheduling */
 
 	int nice;		/* 우선순위에 영향을 주는 값 */
 	int recent_cpu; /* 최근에 얼마나 많은 CPU time을 사용했는가를 표현 */
+	int recent_cpu_epoch; /* recent_cpu가 마지막으로 감쇠된 epoch */
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
@@ -118,12 +135,15 @@ struct thread
 #endif
 
 	/* Owned by thread.c. */
-	struct intr_frame tf; /* Information for switching */
+	uint64_t switch_rsp;  /* Saved kernel stack pointer, see switch.S. */
+	struct intr_frame tf; /* Scratch frame for user context set-up. */
 	unsigned magic;		  /* Detects stack overflow. */
 
 	/* 자식 프로세스 순회용 리스트 */
 	struct list child_list;
 	struct list_elem child_elem;
+	tid_t parent_tid;		   /* 부모의 tid, wait 된 후에는 TID_ERROR */
+	struct list_elem tid_elem; /* tid 해시 버킷 원소 */
 
 	/* wait_sema 를 이용하여 자식 프로세스가 종료할때까지 대기함. 종료 상태를 저장 */
 	struct semaphore wait_sema;
@@ -141,6 +161,7 @@ struct thread
 	 */
 	struct file **fdTable; // 배열로 구현?
 	int fdIdx;
+	int fdCap; /* fdTable에 할당된 엔트리 수 (한 페이지에서 시작해 필요할 때 확장) */
 
 	// stdin_count와 stdout_count?
 	// 표준입출력인 fd가 여러 개인 경우를 고려하여 만든 변수.
@@ -184,12 +205,21 @@ void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
+void thread_sleep(int64_t ticks);
+void thread_awake(int64_t ticks);
+void update_next_tick_to_awake(int64_t ticks);
+int64_t get_next_tick_to_awake(void);
+bool cmp_wakeup_tick(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+
 void test_max_priority(void);
 bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 
 void donate_priority(void);
-void remove_with_lock(struct lock *lock);
+void donate_priority_chain(struct lock *, int priority, int depth);
 void refresh_priority(void);
+int thread_donated_priority(struct thread *t);
+bool cmp_lock_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+void thread_set_effective_priority(struct thread *t, int priority);
 
 void mlfqs_priority(struct thread *t);
 void mlfqs_recent_cpu(struct thread *t);
@@ -197,11 +227,17 @@ void mlfqs_load_avg(void);
 void mlfqs_increment(void);
 void mlfqs_recalc_priority(void);
 void mlfqs_recalc_recent_cpu(void);
+void mlfqs_refresh_ready(void);
 int thread_get_recent_cpu(void);
 
 void do_iret(struct intr_frame *tf);
 
 #define FDT_PAGES 3
-#define FDCOUNT_LIMIT FDT_PAGES *(1 << 9)
+#define FDT_SLOTS_PER_PAGE (1 << 9) /* PGSIZE / sizeof (struct file *) */
+#define FDCOUNT_LIMIT FDT_PAGES *FDT_SLOTS_PER_PAGE
+
+bool thread_fdt_grow(struct thread *t, int fd);
+struct thread *thread_by_tid(tid_t tid);
+void thread_wake_reaper(void);
 
 #endif /* threads/thread.h */
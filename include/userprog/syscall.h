@@ -6,8 +6,8 @@
 void syscall_init(void);
 
 /* 파일 사용시 lock하여 상호배제 구현
- * Read, Write 시 파일에 대한 동시접근이 일어날 수 있으므로 Lock 사용
+ * Read는 여러 스레드가 동시에(shared), Write와 open은 단독으로(exclusive) 수행
  */
-struct lock file_rw_lock;
+extern struct rwlock file_rw_lock;
 
 #endif /* userprog/syscall.h */
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "lib/kernel/hash.h"
 
 enum vm_type
@@ -83,6 +84,11 @@ struct segment
 	size_t written_bytes; //struct file_page를 spt_copy해올때 필요
 };
 
+/* Object caches for the structures above, created by vm_init(). */
+extern struct kmem_cache *page_slab;
+extern struct kmem_cache *frame_slab;
+extern struct kmem_cache *segment_slab;
+
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
  * Put the table of "method" into the struct's member, and
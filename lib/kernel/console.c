@@ -9,6 +9,27 @@
 
 static void vprintf_helper (char, void *);
 static void putchar_have_lock (uint8_t c);
+static void putbuf_have_lock (const char *, size_t);
+
+/* vprintf() output is collected in chunks of this many bytes
+   before being handed to the serial port in one batch. */
+#define VPRINTF_CHUNK 64
+
+/* Auxiliary data for vprintf_helper(). */
+struct vprintf_aux {
+	int char_cnt;                   /* Characters written so far. */
+	size_t len;                     /* Bytes pending in BUF. */
+	char buf[VPRINTF_CHUNK];        /* Pending bytes. */
+	struct vprintf_aux *prev;       /* vprintf() this one interrupted. */
+};
+
+/* Innermost vprintf() in progress, if any.  A vprintf() from an
+   interrupt handler or a recursive one links to the one it
+   interrupted, so console_panic() can push out what every one of
+   them still holds in BUF before the panic message. */
+static struct vprintf_aux *vprintf_pending;
+
+static void vprintf_flush (struct vprintf_aux *);
 
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -72,6 +93,7 @@ console_init (void) {
 void
 console_panic (void) {
 	use_console_lock = false;
+	vprintf_flush (vprintf_pending);
 }
 
 /* Prints console statistics. */
@@ -116,13 +138,19 @@ console_locked_by_current_thread (void) {
    Writes its output to both vga display and serial port. */
 int
 vprintf (const char *format, va_list args) {
-	int char_cnt = 0;
+	struct vprintf_aux aux;
 
+	aux.char_cnt = 0;
+	aux.len = 0;
 	acquire_console ();
-	__vprintf (format, args, vprintf_helper, &char_cnt);
+	aux.prev = vprintf_pending;
+	vprintf_pending = &aux;
+	__vprintf (format, args, vprintf_helper, &aux);
+	vprintf_pending = aux.prev;
+	putbuf_have_lock (aux.buf, aux.len);
 	release_console ();
 
-	return char_cnt;
+	return aux.char_cnt;
 }
 
 /* Writes string S to the console, followed by a new-line
@@ -142,8 +170,7 @@ puts (const char *s) {
 void
 putbuf (const char *buffer, size_t n) {
 	acquire_console ();
-	while (n-- > 0)
-		putchar_have_lock (*buffer++);
+	putbuf_have_lock (buffer, n);
 	release_console ();
 }
 
@@ -159,10 +186,28 @@ putchar (int c) {
 
 /* Helper function for vprintf(). */
 static void
-vprintf_helper (char c, void *char_cnt_) {
-	int *char_cnt = char_cnt_;
-	(*char_cnt)++;
-	putchar_have_lock (c);
+vprintf_helper (char c, void *aux_) {
+	struct vprintf_aux *aux = aux_;
+	aux->char_cnt++;
+	aux->buf[aux->len++] = c;
+	if (aux->len == sizeof aux->buf) {
+		aux->len = 0;
+		putbuf_have_lock (aux->buf, sizeof aux->buf);
+	}
+}
+
+/* Writes out the bytes pending in AUX and in every vprintf()
+   it interrupted, oldest first, and empties them. */
+static void
+vprintf_flush (struct vprintf_aux *aux) {
+	size_t len;
+
+	if (aux == NULL)
+		return;
+	vprintf_flush (aux->prev);
+	len = aux->len;
+	aux->len = 0;
+	putbuf_have_lock (aux->buf, len);
 }
 
 /* Writes C to the vga display and serial port.
@@ -175,3 +220,18 @@ putchar_have_lock (uint8_t c) {
 	serial_putc (c);
 	vga_putc (c);
 }
+
+/* Writes the N characters in BUFFER to the vga display and
+   serial port.  The serial port takes them in one batch.
+   The caller has already acquired the console lock if
+   appropriate. */
+static void
+putbuf_have_lock (const char *buffer, size_t n) {
+	size_t i;
+
+	ASSERT (console_locked_by_current_thread ());
+	write_cnt += n;
+	serial_putbuf (buffer, n);
+	for (i = 0; i < n; i++)
+		vga_putc (buffer[i]);
+}
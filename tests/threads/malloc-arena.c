@@ -0,0 +1,79 @@
+/* Checks that malloc() keeps one empty arena per block size and
+   gives the others back to the page allocator.  Blocks filling
+   several 1 kB arenas are allocated, and then every free page of
+   the kernel pool is taken.  Freeing the blocks must return pages
+   to the pool, because only one empty arena is kept.  Once those
+   pages are taken too, a new block must still come from the kept
+   arena without any page from the pool.
+
+   Nothing is printed until the pool is given back. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+
+#define BLOCK_SIZE 1000
+#define BLOCK_CNT 8
+
+/* Header written at the start of each page taken, to chain them
+   together without needing any other memory. */
+struct link
+  {
+    struct link *next;
+  };
+
+/* Takes every free page of the kernel pool, chains them onto
+   *HEAD, and returns how many there were. */
+static size_t
+take_all (struct link **head)
+{
+  struct link *l;
+  size_t cnt = 0;
+
+  while ((l = palloc_get_page (0)) != NULL)
+    {
+      l->next = *head;
+      *head = l;
+      cnt++;
+    }
+  return cnt;
+}
+
+void
+test_malloc_arena (void)
+{
+  void *blocks[BLOCK_CNT];
+  struct link *pages = NULL;
+  size_t returned;
+  void *b;
+  int i;
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      blocks[i] = malloc (BLOCK_SIZE);
+      if (blocks[i] == NULL)
+        fail ("malloc() failed");
+    }
+
+  take_all (&pages);
+  for (i = 0; i < BLOCK_CNT; i++)
+    free (blocks[i]);
+  returned = take_all (&pages);
+  b = malloc (BLOCK_SIZE);
+  free (b);
+
+  while (pages != NULL)
+    {
+      struct link *next = pages->next;
+      palloc_free_page (pages);
+      pages = next;
+    }
+
+  msg ("Empty arenas went back to the page allocator: %s.",
+       returned > 0 ? "yes" : "no");
+  msg ("Kept arena served a block with no free pages: %s.",
+       b != NULL ? "yes" : "no");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-arena) begin
+(malloc-arena) Empty arenas went back to the page allocator: yes.
+(malloc-arena) Kept arena served a block with no free pages: yes.
+(malloc-arena) end
+EOF
+pass;
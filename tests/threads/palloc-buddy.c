@@ -0,0 +1,91 @@
+/* Checks that the buddy allocator coalesces freed pages.  The
+   user pool is carved into as many 32-page blocks as it has,
+   which are freed again.  Then the whole pool is taken one page
+   at a time, and those pages are freed in two interleaved
+   passes, so that no page is freed next to its buddy in the first
+   pass.  Afterward the pool must again yield exactly as many
+   32-page blocks as at first.
+
+   Nothing is printed until the end: printing can sleep, which
+   would let the zeroer take pages in the middle of the count. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+
+#define BLOCK_PAGES 32
+
+/* Header written at the start of each allocation, to chain them
+   together without needing any other memory. */
+struct link
+  {
+    struct link *next;
+  };
+
+/* Allocates PAGE_CNT-page blocks from the user pool until it runs
+   out, chains them onto *HEAD, and returns how many it got. */
+static size_t
+take_all (size_t page_cnt, struct link **head)
+{
+  struct link *l;
+  size_t cnt = 0;
+
+  *head = NULL;
+  while ((l = palloc_get_multiple (PAL_USER, page_cnt)) != NULL)
+    {
+      l->next = *head;
+      *head = l;
+      cnt++;
+    }
+  return cnt;
+}
+
+/* Frees every PAGE_CNT-page block chained from HEAD. */
+static void
+free_all (struct link *head, size_t page_cnt)
+{
+  while (head != NULL)
+    {
+      struct link *next = head->next;
+      palloc_free_multiple (head, page_cnt);
+      head = next;
+    }
+}
+
+void
+test_palloc_buddy (void)
+{
+  struct link *blocks, *pages, *l;
+  size_t before, after, page_cnt;
+
+  before = take_all (BLOCK_PAGES, &blocks);
+  free_all (blocks, BLOCK_PAGES);
+
+  /* Free every other page, then the rest. */
+  page_cnt = take_all (1, &pages);
+  for (l = pages; l != NULL; l = l->next)
+    {
+      struct link *victim = l->next;
+      if (victim != NULL)
+        {
+          l->next = victim->next;
+          palloc_free_page (victim);
+        }
+    }
+  free_all (pages, 1);
+
+  after = take_all (BLOCK_PAGES, &blocks);
+  free_all (blocks, BLOCK_PAGES);
+
+  if (before == 0)
+    fail ("user pool has no %d-page block", BLOCK_PAGES);
+  if (page_cnt < before * BLOCK_PAGES)
+    fail ("got %zu single pages but %zu %d-page blocks",
+          page_cnt, before, BLOCK_PAGES);
+  if (after != before)
+    fail ("%zu %d-page blocks before, %zu after", before, BLOCK_PAGES, after);
+  msg ("Freed single pages coalesced into as many %d-page blocks as before.",
+       BLOCK_PAGES);
+}
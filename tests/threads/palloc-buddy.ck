@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) Freed single pages coalesced into as many 32-page blocks as before.
+(palloc-buddy) end
+EOF
+pass;
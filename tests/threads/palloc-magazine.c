@@ -0,0 +1,61 @@
+/* Checks the per-CPU page caches in front of palloc_get_page().
+   A freed page must come straight back on the next allocation,
+   and a run of freed pages must come back in reverse order, as
+   from a stack.  Then more pages than a cache holds are freed,
+   so that the cache gives some back to the pool, and the same
+   number allocated again must all be distinct. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+
+#define RUN_CNT 8
+#define MANY_CNT 64
+
+void
+test_palloc_magazine (void)
+{
+  void *run[RUN_CNT], *again[RUN_CNT];
+  static void *many[MANY_CNT];
+  void *p, *q;
+  bool reversed = true;
+  int i, j;
+
+  p = palloc_get_page (PAL_ASSERT);
+  palloc_free_page (p);
+  q = palloc_get_page (PAL_ASSERT);
+  palloc_free_page (q);
+
+  for (i = 0; i < RUN_CNT; i++)
+    run[i] = palloc_get_page (PAL_ASSERT);
+  for (i = 0; i < RUN_CNT; i++)
+    palloc_free_page (run[i]);
+  for (i = 0; i < RUN_CNT; i++)
+    again[i] = palloc_get_page (PAL_ASSERT);
+  for (i = 0; i < RUN_CNT; i++)
+    {
+      if (again[i] != run[RUN_CNT - 1 - i])
+        reversed = false;
+      palloc_free_page (again[i]);
+    }
+
+  for (i = 0; i < MANY_CNT; i++)
+    many[i] = palloc_get_page (PAL_ASSERT);
+  for (i = 0; i < MANY_CNT; i++)
+    palloc_free_page (many[i]);
+  for (i = 0; i < MANY_CNT; i++)
+    {
+      many[i] = palloc_get_page (PAL_ASSERT);
+      for (j = 0; j < i; j++)
+        if (many[j] == many[i])
+          fail ("page %p handed out twice", many[i]);
+    }
+  for (i = 0; i < MANY_CNT; i++)
+    palloc_free_page (many[i]);
+
+  msg ("Freed page came straight back: %s.", p == q ? "yes" : "no");
+  msg ("Freed run came back in reverse order: %s.", reversed ? "yes" : "no");
+  msg ("%d pages freed past the cache came back distinct.", MANY_CNT);
+}
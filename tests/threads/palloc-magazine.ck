@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-magazine) begin
+(palloc-magazine) Freed page came straight back: yes.
+(palloc-magazine) Freed run came back in reverse order: yes.
+(palloc-magazine) 64 pages freed past the cache came back distinct.
+(palloc-magazine) end
+EOF
+pass;
@@ -0,0 +1,75 @@
+/* The main thread acquires a lock.  A medium-priority thread
+   makes itself the owner of a semaphore and then blocks on the
+   lock.  A high-priority thread downs the semaphore, donating
+   its priority to the medium thread and, through the lock, to
+   the main thread.  When the main thread ups the semaphore, the
+   donation goes away, and the main thread must drop back to the
+   medium thread's priority even though the medium thread is
+   still waiting for the lock. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct drop_data
+  {
+    struct lock lock;
+    struct semaphore sema;
+  };
+
+static thread_func medium_thread_func;
+static thread_func high_thread_func;
+
+void
+test_priority_donate_drop (void)
+{
+  struct drop_data data;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&data.lock);
+  sema_init (&data.sema, 0);
+  lock_acquire (&data.lock);
+
+  thread_create ("medium", PRI_DEFAULT + 1, medium_thread_func, &data);
+  thread_create ("high", PRI_DEFAULT + 9, high_thread_func, &data);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 9, thread_get_priority ());
+
+  sema_up (&data.sema);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+
+  lock_release (&data.lock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+medium_thread_func (void *data_)
+{
+  struct drop_data *data = data_;
+
+  sema_set_owner (&data->sema, thread_current ());
+  lock_acquire (&data->lock);
+  msg ("medium: got the lock");
+  lock_release (&data->lock);
+  sema_set_owner (&data->sema, NULL);
+  msg ("medium: done");
+}
+
+static void
+high_thread_func (void *data_)
+{
+  struct drop_data *data = data_;
+
+  sema_down (&data->sema);
+  msg ("high: got the semaphore");
+  msg ("high: done");
+}
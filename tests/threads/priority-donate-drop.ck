@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-drop) begin
+(priority-donate-drop) This thread should have priority 40.  Actual priority: 40.
+(priority-donate-drop) high: got the semaphore
+(priority-donate-drop) high: done
+(priority-donate-drop) This thread should have priority 32.  Actual priority: 32.
+(priority-donate-drop) medium: got the lock
+(priority-donate-drop) medium: done
+(priority-donate-drop) This thread should have priority 31.  Actual priority: 31.
+(priority-donate-drop) end
+EOF
+pass;
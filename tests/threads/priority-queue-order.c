@@ -0,0 +1,57 @@
+/* Checks the ready queue.  While the main thread runs at PRI_MAX,
+   it creates two threads at each of ten priorities, in scrambled
+   order, so that all twenty sit on the ready queue at once.  When
+   the main thread drops back to PRI_DEFAULT, they must run from
+   the highest priority down, and the two threads of each priority
+   in the order they were created. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+#define LEVEL_CNT 10
+#define THREAD_CNT (LEVEL_CNT * 2)
+
+static thread_func record_thread_func;
+
+static int order[THREAD_CNT];
+static int order_cnt;
+
+void
+test_priority_queue_order (void)
+{
+  static const int levels[LEVEL_CNT] = {4, 9, 1, 7, 3, 10, 2, 8, 5, 6};
+  int round, i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  thread_set_priority (PRI_MAX);
+  for (round = 0; round < 2; round++)
+    for (i = 0; i < LEVEL_CNT; i++)
+      {
+        int priority = PRI_DEFAULT + levels[i];
+        char name[16];
+
+        snprintf (name, sizeof name, "p%d-%d", priority, round);
+        thread_create (name, priority, record_thread_func,
+                       (void *) (intptr_t) (priority * 2 + round));
+      }
+  msg ("%d threads created.", THREAD_CNT);
+  thread_set_priority (PRI_DEFAULT);
+
+  for (i = 0; i < order_cnt; i++)
+    msg ("Thread of priority %d, created in round %d, ran.",
+         order[i] / 2, order[i] % 2);
+}
+
+static void
+record_thread_func (void *id_)
+{
+  order[order_cnt++] = (intptr_t) id_;
+}
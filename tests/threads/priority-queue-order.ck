@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-queue-order) begin
+(priority-queue-order) 20 threads created.
+(priority-queue-order) Thread of priority 41, created in round 0, ran.
+(priority-queue-order) Thread of priority 41, created in round 1, ran.
+(priority-queue-order) Thread of priority 40, created in round 0, ran.
+(priority-queue-order) Thread of priority 40, created in round 1, ran.
+(priority-queue-order) Thread of priority 39, created in round 0, ran.
+(priority-queue-order) Thread of priority 39, created in round 1, ran.
+(priority-queue-order) Thread of priority 38, created in round 0, ran.
+(priority-queue-order) Thread of priority 38, created in round 1, ran.
+(priority-queue-order) Thread of priority 37, created in round 0, ran.
+(priority-queue-order) Thread of priority 37, created in round 1, ran.
+(priority-queue-order) Thread of priority 36, created in round 0, ran.
+(priority-queue-order) Thread of priority 36, created in round 1, ran.
+(priority-queue-order) Thread of priority 35, created in round 0, ran.
+(priority-queue-order) Thread of priority 35, created in round 1, ran.
+(priority-queue-order) Thread of priority 34, created in round 0, ran.
+(priority-queue-order) Thread of priority 34, created in round 1, ran.
+(priority-queue-order) Thread of priority 33, created in round 0, ran.
+(priority-queue-order) Thread of priority 33, created in round 1, ran.
+(priority-queue-order) Thread of priority 32, created in round 0, ran.
+(priority-queue-order) Thread of priority 32, created in round 1, ran.
+(priority-queue-order) end
+EOF
+pass;
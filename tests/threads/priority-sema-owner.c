@@ -0,0 +1,58 @@
+/* The main thread makes itself the owner of a semaphore.  Two
+   threads of different priorities block on it, and each must
+   donate its priority to the main thread.  Each sema_up() by the
+   main thread wakes the highest-priority waiter and drops the
+   donation it made.  Once the main thread is no longer the owner,
+   a new waiter must not donate to it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func waiter_thread_func;
+
+void
+test_priority_sema_owner (void)
+{
+  struct semaphore sema;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  sema_init (&sema, 0);
+  sema_set_owner (&sema, thread_current ());
+
+  thread_create ("high", PRI_DEFAULT + 10, waiter_thread_func, &sema);
+  thread_create ("medium", PRI_DEFAULT + 5, waiter_thread_func, &sema);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 10, thread_get_priority ());
+
+  sema_up (&sema);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+
+  sema_up (&sema);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  sema_set_owner (&sema, NULL);
+  thread_create ("low", PRI_DEFAULT + 3, waiter_thread_func, &sema);
+  msg ("Without an owner, this thread should have priority %d.  "
+       "Actual priority: %d.", PRI_DEFAULT, thread_get_priority ());
+  sema_up (&sema);
+  msg ("high, medium, low must already have finished, in that order.");
+}
+
+static void
+waiter_thread_func (void *sema_)
+{
+  struct semaphore *sema = sema_;
+
+  sema_down (sema);
+  msg ("%s: got the semaphore", thread_name ());
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-sema-owner) begin
+(priority-sema-owner) This thread should have priority 41.  Actual priority: 41.
+(priority-sema-owner) high: got the semaphore
+(priority-sema-owner) This thread should have priority 36.  Actual priority: 36.
+(priority-sema-owner) medium: got the semaphore
+(priority-sema-owner) This thread should have priority 31.  Actual priority: 31.
+(priority-sema-owner) Without an owner, this thread should have priority 31.  Actual priority: 31.
+(priority-sema-owner) low: got the semaphore
+(priority-sema-owner) high, medium, low must already have finished, in that order.
+(priority-sema-owner) end
+EOF
+pass;
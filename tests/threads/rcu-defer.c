@@ -0,0 +1,94 @@
+/* Checks read-copy-update.  The main thread unlinks an element
+   of a list while it is inside a read-side critical section and
+   hands it to call_rcu().  The callback must not run while the
+   read section is open, and the unlinked element must still be
+   readable there.  Once the section ends and the main thread
+   blocks, the reaper runs the callback exactly once.
+   synchronize_rcu() must return as well. */
+
+#include <list.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/rcu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define NODE_CNT 3
+
+struct node
+  {
+    struct list_elem elem;
+    struct rcu_head rcu;
+    int value;
+    int reclaimed;              /* Times the callback ran on it. */
+  };
+
+static struct semaphore reclaim_sema;
+
+static void node_reclaim (struct rcu_head *);
+static int sum_list (struct list *);
+
+void
+test_rcu_defer (void)
+{
+  struct node nodes[NODE_CNT];
+  struct list list;
+  int reclaimed, value;
+  int i;
+
+  list_init (&list);
+  sema_init (&reclaim_sema, 0);
+  for (i = 0; i < NODE_CNT; i++)
+    {
+      nodes[i].value = i + 1;
+      nodes[i].reclaimed = 0;
+      list_push_back (&list, &nodes[i].elem);
+    }
+  msg ("Sum of the list: %d.", sum_list (&list));
+
+  /* Printing could sleep, so only record what we see here. */
+  rcu_read_lock ();
+  list_remove (&nodes[1].elem);
+  call_rcu (&nodes[1].rcu, node_reclaim);
+  reclaimed = nodes[1].reclaimed;
+  value = nodes[1].value;
+  rcu_read_unlock ();
+  msg ("Inside the read section, callback ran %d times.", reclaimed);
+  msg ("Unlinked node is still readable: value %d.", value);
+
+  sema_down (&reclaim_sema);
+  msg ("After the read section, callback ran %d times.",
+       nodes[1].reclaimed);
+  msg ("Sum of the list: %d.", sum_list (&list));
+
+  synchronize_rcu ();
+  msg ("synchronize_rcu() returned.");
+  msg ("Callback ran %d times in all.", nodes[1].reclaimed);
+}
+
+/* Returns the sum of the values in LIST, read under RCU. */
+static int
+sum_list (struct list *list)
+{
+  struct list_elem *e;
+  int sum = 0;
+
+  rcu_read_lock ();
+  for (e = list_begin (list); e != list_end (list); e = list_next (e))
+    sum += list_entry (e, struct node, elem)->value;
+  rcu_read_unlock ();
+  return sum;
+}
+
+static void
+node_reclaim (struct rcu_head *head)
+{
+  struct node *n = (struct node *) ((uint8_t *) head
+                                     - offsetof (struct node, rcu));
+
+  n->reclaimed++;
+  sema_up (&reclaim_sema);
+}
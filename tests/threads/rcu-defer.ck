@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rcu-defer) begin
+(rcu-defer) Sum of the list: 6.
+(rcu-defer) Inside the read section, callback ran 0 times.
+(rcu-defer) Unlinked node is still readable: value 2.
+(rcu-defer) After the read section, callback ran 1 times.
+(rcu-defer) Sum of the list: 4.
+(rcu-defer) synchronize_rcu() returned.
+(rcu-defer) Callback ran 1 times in all.
+(rcu-defer) end
+EOF
+pass;
@@ -0,0 +1,74 @@
+/* Checks that a read-side critical section is not preempted.  A
+   higher-priority thread blocks on a semaphore.  While the main
+   thread is inside a read section, the semaphore is raised, first
+   from an interrupt handler and then by the main thread itself.
+   Either way the woken thread must not run until the main thread
+   leaves the read section, and must run as soon as it does. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/rcu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* IRQ 7 has no device behind it, so the test may claim it. */
+#define TEST_VEC 0x27
+
+static struct semaphore wake_sema;
+static int wake_cnt;
+
+static thread_func high_thread_func;
+static intr_handler_func wake_interrupt;
+
+void
+test_rcu_preempt (void)
+{
+  int inside, after;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  sema_init (&wake_sema, 0);
+  intr_register_ext (TEST_VEC, wake_interrupt, "rcu-preempt");
+  thread_create ("high", PRI_DEFAULT + 1, high_thread_func, NULL);
+
+  /* Printing could sleep, so only record what we see here. */
+  rcu_read_lock ();
+  asm volatile ("int %0" : : "i" (TEST_VEC));
+  inside = wake_cnt;
+  rcu_read_unlock ();
+  after = wake_cnt;
+  msg ("Woken from an interrupt: ran %d times inside, %d after.",
+       inside, after);
+
+  rcu_read_lock ();
+  sema_up (&wake_sema);
+  inside = wake_cnt;
+  rcu_read_unlock ();
+  after = wake_cnt;
+  msg ("Woken by a reader: ran %d times inside, %d after.",
+       inside - 1, after - 1);
+}
+
+static void
+wake_interrupt (struct intr_frame *f UNUSED)
+{
+  sema_up (&wake_sema);
+}
+
+static void
+high_thread_func (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < 2; i++)
+    {
+      sema_down (&wake_sema);
+      wake_cnt++;
+    }
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rcu-preempt) begin
+(rcu-preempt) Woken from an interrupt: ran 0 times inside, 1 after.
+(rcu-preempt) Woken by a reader: ran 0 times inside, 1 after.
+(rcu-preempt) end
+EOF
+pass;
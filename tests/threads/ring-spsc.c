@@ -0,0 +1,89 @@
+/* Checks the single-producer, single-consumer byte ring.  First
+   a small ring is filled, drained part way, and refilled so that
+   its indexes wrap around, and the bytes must come out in order.
+   Then a producer thread streams bytes through the ring to the
+   main thread, each side yielding when the ring is full or
+   empty, and the main thread must receive every byte in order. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/ring.h"
+
+#define RING_SIZE 8
+#define STREAM_CNT 1000
+
+static thread_func producer_thread_func;
+
+void
+test_ring_spsc (void)
+{
+  uint8_t buf[RING_SIZE];
+  uint8_t in[RING_SIZE + 4], out[RING_SIZE + 4];
+  struct ring ring;
+  size_t i, cnt;
+
+  ring_init (&ring, buf, sizeof buf);
+  msg ("Empty ring: %zu bytes, %zu free.",
+       ring_count (&ring), ring_space (&ring));
+
+  for (i = 0; i < sizeof in; i++)
+    in[i] = i;
+  cnt = ring_put_batch (&ring, in, sizeof in);
+  msg ("Put %zu of %zu bytes, full: %s.", cnt, sizeof in,
+       ring_full (&ring) ? "yes" : "no");
+  if (ring_put (&ring, 0xff))
+    fail ("ring_put() succeeded on a full ring");
+
+  cnt = ring_get_batch (&ring, out, 5);
+  if (cnt != 5 || ring_put_batch (&ring, in + RING_SIZE, 4) != 4)
+    fail ("ring did not wrap around");
+  msg ("After wrapping: %zu bytes, %zu free.",
+       ring_count (&ring), ring_space (&ring));
+  while (ring_get (&ring, &out[cnt]))
+    cnt++;
+  for (i = 0; i < cnt; i++)
+    if (out[i] != in[i])
+      fail ("byte %zu is %d, expected %d", i, out[i], in[i]);
+  msg ("Got %zu bytes back in order, empty: %s.", cnt,
+       ring_empty (&ring) ? "yes" : "no");
+
+  ring_init (&ring, buf, sizeof buf);
+  thread_create ("producer", PRI_DEFAULT, producer_thread_func, &ring);
+  for (i = 0; i < STREAM_CNT; )
+    {
+      uint8_t byte;
+
+      if (!ring_get (&ring, &byte))
+        {
+          thread_yield ();
+          continue;
+        }
+      if (byte != (uint8_t) i)
+        fail ("streamed byte %zu is %d, expected %d", i, byte, (uint8_t) i);
+      i++;
+    }
+  msg ("Streamed %d bytes through the ring in order.", STREAM_CNT);
+}
+
+static void
+producer_thread_func (void *ring_)
+{
+  struct ring *ring = ring_;
+  uint8_t chunk[3];
+  size_t i = 0;
+
+  while (i < STREAM_CNT)
+    {
+      size_t j, n = STREAM_CNT - i < sizeof chunk ? STREAM_CNT - i
+                                                  : sizeof chunk;
+
+      for (j = 0; j < n; j++)
+        chunk[j] = i + j;
+      n = ring_put_batch (ring, chunk, n);
+      i += n;
+      if (n == 0)
+        thread_yield ();
+    }
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-spsc) begin
+(ring-spsc) Empty ring: 0 bytes, 8 free.
+(ring-spsc) Put 8 of 12 bytes, full: yes.
+(ring-spsc) After wrapping: 7 bytes, 1 free.
+(ring-spsc) Got 12 bytes back in order, empty: yes.
+(ring-spsc) Streamed 1000 bytes through the ring in order.
+(ring-spsc) end
+EOF
+pass;
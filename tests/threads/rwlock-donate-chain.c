@@ -0,0 +1,74 @@
+/* The main thread holds a lock.  A second thread holds an rwlock
+   for reading and then blocks on that lock, donating its priority
+   to the main thread.  A high-priority writer that blocks on the
+   rwlock must donate to the reader, and the reader must pass the
+   donation on to the main thread.  When the main thread releases
+   the lock, the reader runs with the writer's priority, and the
+   writer gets the rwlock as soon as the reader lets go. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct chain_data
+  {
+    struct rwlock rw;
+    struct lock lock;
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_donate_chain (void)
+{
+  struct chain_data data;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&data.rw);
+  lock_init (&data.lock);
+
+  lock_acquire (&data.lock);
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &data);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("writer", PRI_DEFAULT + 5, writer_thread_func, &data);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+
+  lock_release (&data.lock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+  msg ("writer, reader must already have finished, in that order.");
+}
+
+static void
+reader_thread_func (void *data_)
+{
+  struct chain_data *data = data_;
+
+  rw_read_acquire (&data->rw);
+  lock_acquire (&data->lock);
+  msg ("reader: got the lock with priority %d.", thread_get_priority ());
+  lock_release (&data->lock);
+  rw_read_release (&data->rw);
+  msg ("reader: done.");
+}
+
+static void
+writer_thread_func (void *data_)
+{
+  struct chain_data *data = data_;
+
+  rw_write_acquire (&data->rw);
+  msg ("writer: got the rwlock.");
+  rw_write_release (&data->rw);
+  msg ("writer: done.");
+}
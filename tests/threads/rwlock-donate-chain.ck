@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate-chain) begin
+(rwlock-donate-chain) This thread should have priority 32.  Actual priority: 32.
+(rwlock-donate-chain) This thread should have priority 36.  Actual priority: 36.
+(rwlock-donate-chain) reader: got the lock with priority 36.
+(rwlock-donate-chain) writer: got the rwlock.
+(rwlock-donate-chain) writer: done.
+(rwlock-donate-chain) reader: done.
+(rwlock-donate-chain) This thread should have priority 31.  Actual priority: 31.
+(rwlock-donate-chain) writer, reader must already have finished, in that order.
+(rwlock-donate-chain) end
+EOF
+pass;
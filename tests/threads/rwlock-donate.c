@@ -0,0 +1,75 @@
+/* The main thread and a second thread both hold an rwlock for
+   reading, and the second thread then blocks on a semaphore.  A
+   high-priority writer that blocks on the rwlock must donate its
+   priority to both readers, including the blocked one.  Each
+   reader drops the donation when it releases the lock, and the
+   writer gets the lock as soon as the last reader lets go. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct donate_data
+  {
+    struct rwlock rw;
+    struct semaphore go;
+    struct thread *reader;
+  };
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_donate (void)
+{
+  struct donate_data data;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&data.rw);
+  sema_init (&data.go, 0);
+
+  rw_read_acquire (&data.rw);
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &data);
+  thread_create ("writer", PRI_DEFAULT + 5, writer_thread_func, &data);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+  msg ("Reader should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, data.reader->priority);
+
+  rw_read_release (&data.rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+  sema_up (&data.go);
+  msg ("writer, reader must already have finished, in that order.");
+}
+
+static void
+reader_thread_func (void *data_)
+{
+  struct donate_data *data = data_;
+
+  data->reader = thread_current ();
+  rw_read_acquire (&data->rw);
+  sema_down (&data->go);
+  rw_read_release (&data->rw);
+  msg ("reader: priority %d after release", thread_get_priority ());
+  msg ("reader: done");
+}
+
+static void
+writer_thread_func (void *data_)
+{
+  struct donate_data *data = data_;
+
+  rw_write_acquire (&data->rw);
+  msg ("writer: got the lock");
+  rw_write_release (&data->rw);
+  msg ("writer: done");
+}
@@ -0,0 +1,58 @@
+/* The main thread acquires an rwlock for reading.  Then it
+   creates three higher-priority threads that also acquire it
+   for reading.  None of them may block: all four threads must
+   hold the lock at the same time.  The readers then finish in
+   priority order. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct reader_data
+  {
+    struct rwlock rw;
+    struct semaphore done;
+  };
+
+static thread_func reader_thread_func;
+
+void
+test_rwlock_readers (void) 
+{
+  struct reader_data data;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  rw_init (&data.rw);
+  sema_init (&data.done, 0);
+
+  rw_read_acquire (&data.rw);
+  for (i = 1; i <= 3; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "reader %d", i);
+      thread_create (name, PRI_DEFAULT + i, reader_thread_func, &data);
+    }
+  msg ("All readers hold the lock at once: %d readers.", data.rw.readers);
+
+  rw_read_release (&data.rw);
+  for (i = 1; i <= 3; i++)
+    sema_up (&data.done);
+  msg ("Readers must already have finished, highest priority first.");
+}
+
+static void
+reader_thread_func (void *data_) 
+{
+  struct reader_data *data = data_;
+
+  rw_read_acquire (&data->rw);
+  msg ("%s: got the lock, %d readers", thread_name (), data->rw.readers);
+  sema_down (&data->done);
+  rw_read_release (&data->rw);
+  msg ("%s: done", thread_name ());
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-readers) begin
+(rwlock-readers) reader 1: got the lock, 2 readers
+(rwlock-readers) reader 2: got the lock, 3 readers
+(rwlock-readers) reader 3: got the lock, 4 readers
+(rwlock-readers) All readers hold the lock at once: 4 readers.
+(rwlock-readers) reader 3: done
+(rwlock-readers) reader 2: done
+(rwlock-readers) reader 1: done
+(rwlock-readers) Readers must already have finished, highest priority first.
+(rwlock-readers) end
+EOF
+pass;
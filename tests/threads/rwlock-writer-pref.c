@@ -0,0 +1,61 @@
+/* The main thread acquires an rwlock for reading.  Then it
+   creates a writer, which blocks, and a higher-priority reader.
+   Because a writer is waiting, the new reader must block too,
+   even though only readers hold the lock.  Both donate their
+   priority to the main thread.  When it releases the lock, the
+   writer must get it first, followed by the reader. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+static thread_func reader_thread_func;
+
+void
+test_rwlock_writer_pref (void)
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("reader", PRI_DEFAULT + 2, reader_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  msg ("Readers holding the lock: %d.", rw.readers);
+  rw_read_release (&rw);
+  msg ("writer, reader must already have got the lock, in that order.");
+}
+
+static void
+writer_thread_func (void *rw_)
+{
+  struct rwlock *rw = rw_;
+
+  rw_write_acquire (rw);
+  msg ("writer: got the lock");
+  rw_write_release (rw);
+  msg ("writer: done");
+}
+
+static void
+reader_thread_func (void *rw_)
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("reader: got the lock");
+  rw_read_release (rw);
+  msg ("reader: done");
+}
@@ -0,0 +1,83 @@
+/* Checks the sequence lock.  A read with no write in between
+   must not be retried, and a read across a write must be.  Then
+   a writer thread updates a pair of values that must always be
+   equal, while the main thread reads them with a yield in the
+   middle of each read section.  Every read that overlaps a write
+   must be retried, so the reader never sees a torn pair. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WRITE_CNT 16
+
+struct seq_data
+  {
+    struct seqlock sl;
+    int a, b;                   /* Always equal outside a write. */
+  };
+
+static thread_func writer_thread_func;
+
+void
+test_seqlock_read (void)
+{
+  struct seq_data data;
+  unsigned start;
+  int a, b;
+  int retries = 0;
+
+  seqlock_init (&data.sl);
+  data.a = data.b = 0;
+
+  start = read_seqbegin (&data.sl);
+  if (read_seqretry (&data.sl, start))
+    fail ("read with no writer was told to retry");
+  msg ("Read with no writer needs no retry.");
+
+  start = read_seqbegin (&data.sl);
+  write_seqlock (&data.sl);
+  write_sequnlock (&data.sl);
+  if (!read_seqretry (&data.sl, start))
+    fail ("read across a write was not told to retry");
+  msg ("Read across a write must retry.");
+
+  thread_create ("writer", PRI_DEFAULT, writer_thread_func, &data);
+  do
+    {
+      start = read_seqbegin (&data.sl);
+      a = data.a;
+      thread_yield ();
+      b = data.b;
+      if (read_seqretry (&data.sl, start))
+        {
+          retries++;
+          continue;
+        }
+      if (a != b)
+        fail ("reader saw a torn pair: %d, %d", a, b);
+    }
+  while (a != WRITE_CNT || b != WRITE_CNT);
+
+  if (retries == 0)
+    fail ("reader never had to retry");
+  msg ("Reader never saw a torn pair.");
+}
+
+static void
+writer_thread_func (void *data_)
+{
+  struct seq_data *data = data_;
+  int i;
+
+  for (i = 1; i <= WRITE_CNT; i++)
+    {
+      write_seqlock (&data->sl);
+      data->a = i;
+      data->b = i;
+      write_sequnlock (&data->sl);
+      thread_yield ();
+    }
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(seqlock-read) begin
+(seqlock-read) Read with no writer needs no retry.
+(seqlock-read) Read across a write must retry.
+(seqlock-read) Reader never saw a torn pair.
+(seqlock-read) end
+EOF
+pass;
@@ -0,0 +1,89 @@
+/* Checks the slab allocator.  Objects must come back constructed
+   and aligned, and the constructor must run when a slab is made,
+   not on every allocation: an object freed and allocated again
+   keeps its contents.  Enough objects to fill several slabs must
+   all be distinct, and free() must hand them back to their cache.
+   One empty slab is kept afterward, so the next allocation runs
+   no constructor. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/thread.h"
+
+#define OBJ_MAGIC 0x0b1ec7
+#define OBJ_CNT 300
+
+struct obj
+  {
+    int magic;                  /* Set by the constructor. */
+    int payload;                /* Left alone by the allocator. */
+    char pad[28];
+  };
+
+static int ctor_cnt;
+
+static void
+obj_ctor (void *obj_)
+{
+  struct obj *obj = obj_;
+
+  obj->magic = OBJ_MAGIC;
+  obj->payload = 0;
+  ctor_cnt++;
+}
+
+void
+test_slab_ctor (void)
+{
+  static struct obj *objs[OBJ_CNT];
+  struct kmem_cache *cache;
+  struct obj *o, *o2;
+  int cnt;
+  int i, j;
+
+  cache = kmem_cache_create ("slab-ctor", sizeof (struct obj), obj_ctor);
+  if (cache == NULL)
+    fail ("kmem_cache_create() failed");
+
+  o = kmem_cache_alloc (cache);
+  if (o == NULL)
+    fail ("kmem_cache_alloc() failed");
+  msg ("Object is constructed: %s.", o->magic == OBJ_MAGIC ? "yes" : "no");
+  msg ("Object belongs to its cache: %s.",
+       kmem_cache_of (o) == cache ? "yes" : "no");
+
+  cnt = ctor_cnt;
+  o->payload = 1234;
+  kmem_cache_free (cache, o);
+  o2 = kmem_cache_alloc (cache);
+  msg ("Reallocated object kept its contents: %s.",
+       o2 == o && o2->payload == 1234 ? "yes" : "no");
+  msg ("Constructor ran again: %s.", ctor_cnt != cnt ? "yes" : "no");
+  o2->payload = 0;
+  kmem_cache_free (cache, o2);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL)
+        fail ("kmem_cache_alloc() failed");
+      if (objs[i]->magic != OBJ_MAGIC || (uintptr_t) objs[i] % 8 != 0)
+        fail ("object %d is not constructed and aligned", i);
+      for (j = 0; j < i; j++)
+        if (objs[j] == objs[i])
+          fail ("object %p handed out twice", objs[i]);
+    }
+  msg ("%d objects are constructed, aligned and distinct.", OBJ_CNT);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    free (objs[i]);
+  cnt = ctor_cnt;
+  o = kmem_cache_alloc (cache);
+  msg ("After freeing all, allocation ran the constructor: %s.",
+       ctor_cnt != cnt ? "yes" : "no");
+  kmem_cache_free (cache, o);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-ctor) begin
+(slab-ctor) Object is constructed: yes.
+(slab-ctor) Object belongs to its cache: yes.
+(slab-ctor) Reallocated object kept its contents: yes.
+(slab-ctor) Constructor ran again: no.
+(slab-ctor) 300 objects are constructed, aligned and distinct.
+(slab-ctor) After freeing all, allocation ran the constructor: no.
+(slab-ctor) end
+EOF
+pass;
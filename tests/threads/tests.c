@@ -29,6 +29,21 @@ static const struct test tests[] =
         {"priority-preempt", test_priority_preempt},
         {"priority-sema", test_priority_sema},
         {"priority-condvar", test_priority_condvar},
+        {"priority-queue-order", test_priority_queue_order},
+        {"rwlock-readers", test_rwlock_readers},
+        {"rwlock-writer-pref", test_rwlock_writer_pref},
+        {"rwlock-donate", test_rwlock_donate},
+        {"rwlock-donate-chain", test_rwlock_donate_chain},
+        {"seqlock-read", test_seqlock_read},
+        {"rcu-defer", test_rcu_defer},
+        {"rcu-preempt", test_rcu_preempt},
+        {"ring-spsc", test_ring_spsc},
+        {"priority-sema-owner", test_priority_sema_owner},
+        {"priority-donate-drop", test_priority_donate_drop},
+        {"palloc-buddy", test_palloc_buddy},
+        {"palloc-magazine", test_palloc_magazine},
+        {"slab-ctor", test_slab_ctor},
+        {"malloc-arena", test_malloc_arena},
         {"mlfqs-load-1", test_mlfqs_load_1},
         {"mlfqs-load-60", test_mlfqs_load_60},
         {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -23,6 +23,21 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_priority_queue_order;
+extern test_func test_rwlock_readers;
+extern test_func test_rwlock_writer_pref;
+extern test_func test_rwlock_donate;
+extern test_func test_rwlock_donate_chain;
+extern test_func test_seqlock_read;
+extern test_func test_rcu_defer;
+extern test_func test_rcu_preempt;
+extern test_func test_ring_spsc;
+extern test_func test_priority_sema_owner;
+extern test_func test_priority_donate_drop;
+extern test_func test_palloc_buddy;
+extern test_func test_palloc_magazine;
+extern test_func test_slab_ctor;
+extern test_func test_malloc_arena;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
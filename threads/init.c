@@ -20,6 +20,7 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -85,6 +86,7 @@ int main(void)
 	// 유저 10mb, 커널 10mb 총 20mb 사용?
 	mem_end = palloc_init();
 	malloc_init();
+	slab_init();
 	paging_init(mem_end);
 
 #ifdef USERPROG
@@ -103,6 +105,7 @@ int main(void)
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start();
+	palloc_start_zeroer();
 	serial_init_queue();
 	timer_calibrate();
 
@@ -228,6 +231,8 @@ parse_options(char **argv)
 			random_init(atoi(value));
 		else if (!strcmp(name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp(name, "-tickless"))
+			timer_tickless = true;
 #ifdef USERPROG
 		else if (!strcmp(name, "-ul"))
 			user_page_limit = atoi(value);
@@ -340,6 +345,7 @@ usage(void)
 		   "  -f                 Format file system disk during startup.\n"
 		   "  -rs=SEED           Set random number seed to SEED.\n"
 		   "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+		   "  -tickless          Stop the timer tick while the CPU is idle.\n"
 #ifdef USERPROG
 		   "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -369,6 +375,11 @@ print_stats(void)
 {
 	timer_print_stats();
 	thread_print_stats();
+	kmem_print_stats();
+	malloc_print_stats();
+#ifdef LOCK_PROFILE
+	lock_print_stats();
+#endif
 #ifdef FILESYS
 	disk_print_stats();
 #endif
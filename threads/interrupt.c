@@ -344,6 +344,12 @@ intr_handler (struct intr_frame *frame) {
 
 		in_external_intr = true;
 		yield_on_return = false;
+
+		/* A device interrupt may end a tickless idle period.  Go
+		   back to the periodic tick before its handler wakes a
+		   thread that we might switch to on return. */
+		if (frame->vec_no != 0x20)
+			timer_idle_exit ();
 	}
 
 	/* Invoke the interrupt's handler. */
@@ -369,8 +375,16 @@ intr_handler (struct intr_frame *frame) {
 		in_external_intr = false;
 		pic_end_of_interrupt (frame->vec_no);
 
-		if (yield_on_return)
-			thread_yield ();
+		/* An RCU reader is never preempted, whichever handler
+		   asked for the yield; it yields when it leaves its read
+		   section instead. */
+		if (yield_on_return) {
+			struct thread *t = thread_current ();
+			if (t->rcu_nesting > 0)
+				t->rcu_yield_deferred = true;
+			else
+				thread_yield ();
+		}
 	}
 }
 
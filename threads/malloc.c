@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
@@ -13,20 +14,24 @@
 
    The size of each request, in bytes, is rounded up to a power
    of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
-
-   When we free a block, we add it to its descriptor's free list.
-   But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
+   that size.  Blocks live in pages called "arenas", and each
+   arena keeps its own list of free blocks.  The descriptor keeps
+   a list of partially used arenas; if it is nonempty, a block
+   is taken from the first of them.
+
+   Otherwise, an arena that has no blocks in use is reused, or a
+   new one is obtained from the page allocator (if none is
+   available, malloc() returns a null pointer).  A new arena is
+   divided into blocks, all of which are added to its free list.
+   Then we return one of its blocks.  Full arenas are on no list.
+
+   When we free a block, we add it to its arena's free list.  If
+   the arena now has no in-use blocks, it is kept for reuse as
+   long as the descriptor holds fewer than MALLOC_EMPTY_MAX empty
+   arenas, and otherwise given back to the page allocator.  This
+   keeps a workload that allocates and frees around an arena
+   boundary from fetching and releasing the same page over and
+   over.
 
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
@@ -34,13 +39,25 @@
    with the page allocator and sticking the allocation size at
    the beginning of the allocated block's arena header. */
 
+/* Empty arenas each descriptor keeps instead of freeing. */
+#define MALLOC_EMPTY_MAX 1
+
 /* Descriptor. */
 struct desc
 {
 	size_t block_size;		 /* Size of each element in bytes. */
 	size_t blocks_per_arena; /* Number of blocks in an arena. */
-	struct list free_list;	 /* List of free blocks. */
-	struct lock lock;		 /* Lock. */
+	struct list partial;	 /* Arenas with some blocks free. */
+	struct list empty;		 /* Arenas with all blocks free. */
+	size_t empty_cnt;		 /* Number of arenas in EMPTY. */
+	struct mutex lock;		 /* Lock.  Held briefly, never across a sleep. */
+
+	/* Statistics, protected by LOCK. */
+	size_t arena_cnt;			 /* Arenas owned, including empty ones. */
+	size_t used_cnt;			 /* Blocks in use. */
+	long long alloc_cnt;		 /* Blocks handed out. */
+	long long arena_alloc_cnt;	 /* Pages taken from palloc. */
+	long long arena_reuse_cnt;	 /* Empty arenas reused. */
 };
 
 /* Magic number for detecting arena corruption. */
@@ -52,6 +69,8 @@ struct arena
 	unsigned magic;	   /* Always set to ARENA_MAGIC. */
 	struct desc *desc; /* Owning descriptor, null for big block. */
 	size_t free_cnt;   /* Free blocks; pages in big block. */
+	struct list free_list;	/* Free blocks, if not a big block. */
+	struct list_elem elem;	/* In desc's PARTIAL or EMPTY list. */
 };
 
 /* Free block. */
@@ -78,8 +97,9 @@ void malloc_init(void)
 		ASSERT(desc_cnt <= sizeof descs / sizeof *descs);
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof(struct arena)) / block_size;
-		list_init(&d->free_list);
-		lock_init(&d->lock);
+		list_init(&d->partial);
+		list_init(&d->empty);
+		mutex_init(&d->lock);
 	}
 }
 
@@ -118,10 +138,20 @@ malloc(size_t size)
 		return a + 1;
 	}
 
-	lock_acquire(&d->lock);
+	mutex_acquire(&d->lock);
 
-	/* If the free list is empty, create a new arena. */
-	if (list_empty(&d->free_list))
+	/* Prefer a partly used arena, then an empty one we kept, and
+	   only then create a new arena. */
+	if (!list_empty(&d->partial))
+		a = list_entry(list_front(&d->partial), struct arena, elem);
+	else if (!list_empty(&d->empty))
+	{
+		a = list_entry(list_pop_front(&d->empty), struct arena, elem);
+		d->empty_cnt--;
+		d->arena_reuse_cnt++;
+		list_push_front(&d->partial, &a->elem);
+	}
+	else
 	{
 		size_t i;
 
@@ -129,26 +159,32 @@ malloc(size_t size)
 		a = palloc_get_page(0);
 		if (a == NULL)
 		{
-			lock_release(&d->lock);
+			mutex_release(&d->lock);
 			return NULL;
 		}
 
-		/* Initialize arena and add its blocks to the free list. */
+		/* Initialize arena and add its blocks to its free list. */
 		a->magic = ARENA_MAGIC;
 		a->desc = d;
 		a->free_cnt = d->blocks_per_arena;
+		list_init(&a->free_list);
 		for (i = 0; i < d->blocks_per_arena; i++)
 		{
 			struct block *b = arena_to_block(a, i);
-			list_push_back(&d->free_list, &b->free_elem);
+			list_push_back(&a->free_list, &b->free_elem);
 		}
+		list_push_front(&d->partial, &a->elem);
+		d->arena_cnt++;
+		d->arena_alloc_cnt++;
 	}
 
-	/* Get a block from free list and return it. */
-	b = list_entry(list_pop_front(&d->free_list), struct block, free_elem);
-	a = block_to_arena(b);
-	a->free_cnt--;
-	lock_release(&d->lock);
+	/* Get a block from the arena's free list and return it. */
+	b = list_entry(list_pop_front(&a->free_list), struct block, free_elem);
+	if (--a->free_cnt == 0)
+		list_remove(&a->elem);
+	d->used_cnt++;
+	d->alloc_cnt++;
+	mutex_release(&d->lock);
 	return b;
 }
 
@@ -213,11 +249,20 @@ realloc(void *old_block, size_t new_size)
 }
 
 /* Frees block P, which must have been previously allocated with
-   malloc(), calloc(), or realloc(). */
+   malloc(), calloc(), or realloc().
+   Objects from kmem_cache_alloc() may be freed here too, for
+   callers that do not know which allocator P came from. */
 void free(void *p)
 {
 	if (p != NULL)
 	{
+		struct kmem_cache *c = kmem_cache_of(p);
+		if (c != NULL)
+		{
+			kmem_cache_free(c, p);
+			return;
+		}
+
 		struct block *b = p;
 		struct arena *a = block_to_arena(b);
 		struct desc *d = a->desc;
@@ -231,26 +276,35 @@ void free(void *p)
 			memset(b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire(&d->lock);
+			mutex_acquire(&d->lock);
 
-			/* Add block to free list. */
-			list_push_front(&d->free_list, &b->free_elem);
+			/* Add block to its arena's free list.  A full arena
+			   becomes partly used again. */
+			list_push_front(&a->free_list, &b->free_elem);
+			if (a->free_cnt++ == 0)
+				list_push_front(&d->partial, &a->elem);
+			d->used_cnt--;
 
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena)
+			/* If the arena is now entirely unused, keep it for
+			   reuse or free it.  Its blocks stay on its own free
+			   list, so neither needs to walk them. */
+			if (a->free_cnt >= d->blocks_per_arena)
 			{
-				size_t i;
-
 				ASSERT(a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++)
+				list_remove(&a->elem);
+				if (d->empty_cnt < MALLOC_EMPTY_MAX)
 				{
-					struct block *b = arena_to_block(a, i);
-					list_remove(&b->free_elem);
+					list_push_front(&d->empty, &a->elem);
+					d->empty_cnt++;
+				}
+				else
+				{
+					d->arena_cnt--;
+					palloc_free_page(a);
 				}
-				palloc_free_page(a);
 			}
 
-			lock_release(&d->lock);
+			mutex_release(&d->lock);
 		}
 		else
 		{
@@ -261,6 +315,41 @@ void free(void *p)
 	}
 }
 
+/* Prints a line per block size: blocks in use against the
+   capacity of the arenas held, the share of that capacity left
+   free in partly used or empty arenas, and how often an arena
+   came from the page allocator versus the kept empty ones. */
+void malloc_print_stats(void)
+{
+	struct desc *d;
+
+	for (d = descs; d < descs + desc_cnt; d++)
+	{
+		size_t used_cnt, arena_cnt, empty_cnt, capacity;
+		long long alloc_cnt, arena_alloc_cnt, arena_reuse_cnt;
+
+		/* Copy the counters out so that printf() does not run
+		   under the descriptor's lock. */
+		mutex_acquire(&d->lock);
+		used_cnt = d->used_cnt;
+		arena_cnt = d->arena_cnt;
+		empty_cnt = d->empty_cnt;
+		alloc_cnt = d->alloc_cnt;
+		arena_alloc_cnt = d->arena_alloc_cnt;
+		arena_reuse_cnt = d->arena_reuse_cnt;
+		mutex_release(&d->lock);
+
+		capacity = arena_cnt * d->blocks_per_arena;
+		if (alloc_cnt > 0)
+			printf("Malloc %zu: %zu/%zu blocks in use, %zu arenas "
+				   "(%zu empty), %zu%% free, %lld allocations, "
+				   "%lld arenas from palloc, %lld reused\n",
+				   d->block_size, used_cnt, capacity, arena_cnt, empty_cnt,
+				   capacity ? (capacity - used_cnt) * 100 / capacity : 0,
+				   alloc_cnt, arena_alloc_cnt, arena_reuse_cnt);
+	}
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena(struct block *b)
@@ -2,14 +2,18 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,25 +28,91 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2**ORDER pages, aligned to their size relative to the
+   pool base, on one free list per order.  A request for N pages
+   takes the smallest block that fits, splitting larger blocks on
+   the way down, and gives the unused tail back; freeing merges a
+   block with its buddy for as long as the buddy is free too.
+   Both take O(log n) list operations.
+
+   The free-list links live outside the pages themselves, next to
+   the pool's bitmap, because early in boot not all of RAM is
+   mapped yet.
+
+   A PRI_MIN "zeroer" thread takes free pages out of each pool
+   while there is nothing better to run, clears them, and keeps
+   up to ZERO_HIGH of them on the pool's zeroed stack.  Single
+   PAL_ZERO pages come from there first and skip the memset.
+   Pages on the stack are still free memory: the other paths fall
+   back on them when the buddy lists run dry. */
+
+/* Largest block is 1 << PALLOC_MAX_ORDER pages. */
+#define PALLOC_MAX_ORDER 10
+#define ORDER_NONE 0xff /* Page does not head a free block. */
+
+#define ZERO_HIGH 64 /* Pre-zeroed pages kept per pool. */
+#define ZERO_LOW 32	 /* Wake the zeroer when a stack is at or below this. */
 
 /* A memory pool. */
 struct pool
 {
-	struct lock lock;		 /* Mutual exclusion. */
-	struct bitmap *used_map; /* Bitmap of free pages. */
+	struct spinlock lock;	 /* Mutual exclusion. */
+	struct bitmap *used_map; /* Bitmap of used pages. */
 	uint8_t *base;			 /* Base of pool. */
+	struct list free_list[PALLOC_MAX_ORDER + 1]; /* Free blocks, per order. */
+	struct list_elem *links; /* Per page: element in free_list. */
+	uint8_t *orders;		 /* Per page: order of the free block it heads. */
+	void *zeroed[ZERO_HIGH]; /* Stack of free pages known to be zero. */
+	size_t zeroed_cnt;		 /* Number of pages in zeroed. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Per-CPU caches ("magazines") of single free pages, one per
+   pool.  A cache is only touched by its own CPU with interrupts
+   off, so single-page palloc_get_page() and palloc_free_page()
+   normally take no lock.  An empty cache is refilled with
+   PCP_BATCH pages from its pool, and a full one gives PCP_BATCH
+   back, under the pool lock.  Cached pages stay marked used in
+   the pool's bitmap. */
+#define PCP_HIGH 32	 /* Pages a cache holds at most. */
+#define PCP_BATCH 8	 /* Pages moved to or from the pool at once. */
+
+struct page_cache
+{
+	size_t cnt;				/* Number of cached pages. */
+	void *pages[PCP_HIGH];	/* Stack of cached pages. */
+};
+
+static struct page_cache page_caches[NCPU_MAX][2];
+
+/* The zeroer sleeps on zero_sema with zeroer_asleep set.  Anyone
+   who leaves a zeroed stack at or below ZERO_LOW clears the flag
+   and ups the semaphore, so it is upped at most once per sleep. */
+static struct semaphore zero_sema;
+static bool zeroer_asleep;
+
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 static void
 init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool(const struct pool *, void *page);
+static void init_free_lists(struct pool *);
+static size_t buddy_alloc(struct pool *, size_t page_cnt);
+static void buddy_free_range(struct pool *, size_t page_idx, size_t page_cnt);
+static void *pool_get(struct pool *, size_t page_cnt);
+static void pool_put(struct pool *, void *pages, size_t page_cnt);
+static void *page_cache_get(struct pool *);
+static void page_cache_put(struct pool *, void *page);
+static void page_cache_drain(struct pool *);
+static void *zeroed_get(struct pool *);
+static void zeroed_drain(struct pool *);
+static void zeroer_wake(size_t zeroed_cnt);
 
 /* multiboot info */
 struct multiboot_info
@@ -281,6 +351,9 @@ palloc_init(void)
 	printf("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		   ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools(&base_mem, &ext_mem);
+	init_free_lists(&kernel_pool);
+	init_free_lists(&user_pool);
+	sema_init(&zero_sema, 0);
 	return ext_mem.end;
 }
 
@@ -299,20 +372,32 @@ void *
 palloc_get_multiple(enum palloc_flags flags, size_t page_cnt)
 {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	bool zeroed = false;
+	void *pages = NULL;
 
-	lock_acquire(&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-	lock_release(&pool->lock);
-	void *pages;
-
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
+	if (page_cnt == 1)
+	{
+		if (flags & PAL_ZERO)
+			zeroed = (pages = zeroed_get(pool)) != NULL;
+		if (pages == NULL)
+			pages = page_cache_get(pool);
+	}
 	else
-		pages = NULL;
+	{
+		pages = pool_get(pool, page_cnt);
+		if (pages == NULL)
+		{
+			/* Our cached single pages and the zeroed stack may be
+			   what keeps a large enough block from forming. */
+			page_cache_drain(pool);
+			zeroed_drain(pool);
+			pages = pool_get(pool, page_cnt);
+		}
+	}
 
 	if (pages)
 	{
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset(pages, 0, PGSIZE * page_cnt);
 	}
 	else
@@ -348,7 +433,6 @@ palloc_get_page(enum palloc_flags flags)
 void palloc_free_multiple(void *pages, size_t page_cnt)
 {
 	struct pool *pool;
-	size_t page_idx;
 
 	ASSERT(pg_ofs(pages) == 0);			// page offset이 0이라면
 	if (pages == NULL || page_cnt == 0) // 페이지가 NULL이거나 page_cnt가 0이라면 종료
@@ -361,13 +445,13 @@ void palloc_free_multiple(void *pages, size_t page_cnt)
 	else
 		NOT_REACHED();
 
-	page_idx = pg_no(pages) - pg_no(pool->base);
-
 #ifndef NDEBUG
 	memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
-	ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+	if (page_cnt == 1)
+		page_cache_put(pool, pages);
+	else
+		pool_put(pool, pages, page_cnt);
 }
 
 /* Frees the page at PAGE. */
@@ -380,15 +464,23 @@ void palloc_free_page(void *page)
 static void
 init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end)
 {
-	/* We'll put the pool's used_map at its base.
-	   Calculate the space needed for the bitmap
+	/* We'll put the pool's used_map at its base, followed by the
+	   buddy allocator's per-page free-list links and orders.
+	   Calculate the space needed for them
 	   and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+	size_t bm_size = ROUND_UP(bitmap_buf_size(pgcnt), sizeof(struct list_elem));
+	size_t links_size = pgcnt * sizeof(struct list_elem);
+	size_t bm_pages = DIV_ROUND_UP(bm_size + links_size + pgcnt, PGSIZE) * PGSIZE;
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
+	spin_lock_init(&p->lock);
+	p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_size);
 	p->base = (void *)start;
+	p->links = (struct list_elem *)((uint8_t *)*bm_base + bm_size);
+	p->orders = (uint8_t *)*bm_base + bm_size + links_size;
+	for (int order = 0; order <= PALLOC_MAX_ORDER; order++)
+		list_init(&p->free_list[order]);
+	memset(p->orders, ORDER_NONE, pgcnt);
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
@@ -396,6 +488,125 @@ init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end)
 	*bm_base += bm_pages;
 }
 
+/* Puts every page that populate_pools() marked usable in POOL on
+   its free lists. */
+static void
+init_free_lists(struct pool *pool)
+{
+	size_t page_cnt = bitmap_size(pool->used_map);
+	size_t start = bitmap_scan(pool->used_map, 0, 1, false);
+
+	while (start != BITMAP_ERROR)
+	{
+		size_t end = bitmap_scan(pool->used_map, start, 1, true);
+		if (end == BITMAP_ERROR)
+			end = page_cnt;
+		buddy_free_range(pool, start, end - start);
+		start = end < page_cnt ? bitmap_scan(pool->used_map, end, 1, false) : BITMAP_ERROR;
+	}
+}
+
+/* Returns the smallest order whose blocks hold PAGE_CNT pages. */
+static int
+order_for(size_t page_cnt)
+{
+	int order = 0;
+
+	while (((size_t)1 << order) < page_cnt)
+		order++;
+	return order;
+}
+
+/* Puts the free block of 2**ORDER pages at PAGE_IDX on its free
+   list. */
+static void
+buddy_push(struct pool *pool, size_t page_idx, int order)
+{
+	pool->orders[page_idx] = order;
+	list_push_front(&pool->free_list[order], &pool->links[page_idx]);
+}
+
+/* Takes the free block at PAGE_IDX off its free list. */
+static void
+buddy_pop(struct pool *pool, size_t page_idx)
+{
+	list_remove(&pool->links[page_idx]);
+	pool->orders[page_idx] = ORDER_NONE;
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX, merging it with
+   its buddy as long as the buddy is a free block of the same
+   order. */
+static void
+buddy_free(struct pool *pool, size_t page_idx, int order)
+{
+	size_t page_cnt = bitmap_size(pool->used_map);
+
+	ASSERT(pool->orders[page_idx] == ORDER_NONE);
+	while (order < PALLOC_MAX_ORDER)
+	{
+		size_t buddy = page_idx ^ ((size_t)1 << order);
+		if (buddy >= page_cnt || pool->orders[buddy] != order)
+			break;
+		buddy_pop(pool, buddy);
+		if (buddy < page_idx)
+			page_idx = buddy;
+		order++;
+	}
+	buddy_push(pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX, which need not form a
+   single block, by splitting them into the largest aligned
+   blocks. */
+static void
+buddy_free_range(struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+	while (page_cnt > 0)
+	{
+		int order = 0;
+
+		while (order < PALLOC_MAX_ORDER
+			   && (page_idx & ((2 << order) - 1)) == 0
+			   && ((size_t)2 << order) <= page_cnt)
+			order++;
+		buddy_free(pool, page_idx, order);
+		page_idx += (size_t)1 << order;
+		page_cnt -= (size_t)1 << order;
+	}
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or BITMAP_ERROR if no block is big enough.
+   Takes the smallest free block that fits, splits it down to
+   the required order, and frees the pages past PAGE_CNT. */
+static size_t
+buddy_alloc(struct pool *pool, size_t page_cnt)
+{
+	int order = order_for(page_cnt);
+	int o = order;
+	size_t page_idx;
+
+	ASSERT(page_cnt > 0);
+	if (order > PALLOC_MAX_ORDER)
+		return BITMAP_ERROR;
+
+	while (o <= PALLOC_MAX_ORDER && list_empty(&pool->free_list[o]))
+		o++;
+	if (o > PALLOC_MAX_ORDER)
+		return BITMAP_ERROR;
+
+	page_idx = list_front(&pool->free_list[o]) - pool->links;
+	buddy_pop(pool, page_idx);
+	while (o > order)
+	{
+		o--;
+		buddy_push(pool, page_idx + ((size_t)1 << o), o);
+	}
+	buddy_free_range(pool, page_idx + page_cnt, ((size_t)1 << order) - page_cnt);
+	return page_idx;
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
@@ -406,3 +617,258 @@ page_from_pool(const struct pool *pool, void *page)
 	size_t end_page = start_page + bitmap_size(pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Allocates PAGE_CNT contiguous pages from POOL itself, bypassing
+   the page caches.  Returns a null pointer on failure. */
+static void *
+pool_get(struct pool *pool, size_t page_cnt)
+{
+	size_t page_idx;
+
+	spin_lock(&pool->lock);
+	page_idx = buddy_alloc(pool, page_cnt);
+	if (page_idx != BITMAP_ERROR)
+	{
+		ASSERT(!bitmap_any(pool->used_map, page_idx, page_cnt));
+		bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+	}
+	spin_unlock(&pool->lock);
+
+	return page_idx != BITMAP_ERROR ? pool->base + PGSIZE * page_idx : NULL;
+}
+
+/* Returns the PAGE_CNT pages at PAGES to POOL itself. */
+static void
+pool_put(struct pool *pool, void *pages, size_t page_cnt)
+{
+	size_t page_idx = pg_no(pages) - pg_no(pool->base);
+
+	spin_lock(&pool->lock);
+	if (!bitmap_all(pool->used_map, page_idx, page_cnt))
+		PANIC("palloc_free_multiple: double free of %p", pages);
+	bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+	buddy_free_range(pool, page_idx, page_cnt);
+	spin_unlock(&pool->lock);
+}
+
+/* Returns the running CPU's cache for POOL.
+   Interrupts must be off. */
+static struct page_cache *
+page_cache(struct pool *pool)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	return &page_caches[this_cpu()->id][pool == &user_pool];
+}
+
+/* Takes a single page from the running CPU's cache for POOL,
+   refilling the cache from POOL if it is empty.  Returns a null
+   pointer if POOL has no free pages either. */
+static void *
+page_cache_get(struct pool *pool)
+{
+	enum intr_level old_level = intr_disable();
+	struct page_cache *pc = page_cache(pool);
+	size_t zeroed_cnt = ZERO_HIGH;
+	void *page = NULL;
+
+	if (pc->cnt == 0)
+	{
+		spin_lock(&pool->lock);
+		while (pc->cnt < PCP_BATCH)
+		{
+			size_t page_idx = buddy_alloc(pool, 1);
+			if (page_idx != BITMAP_ERROR)
+			{
+				ASSERT(!bitmap_test(pool->used_map, page_idx));
+				bitmap_mark(pool->used_map, page_idx);
+				pc->pages[pc->cnt++] = pool->base + PGSIZE * page_idx;
+			}
+			else if (pool->zeroed_cnt > 0)
+				pc->pages[pc->cnt++] = pool->zeroed[--pool->zeroed_cnt];
+			else
+				break;
+		}
+		zeroed_cnt = pool->zeroed_cnt;
+		spin_unlock(&pool->lock);
+	}
+	if (pc->cnt > 0)
+		page = pc->pages[--pc->cnt];
+	intr_set_level(old_level);
+
+	zeroer_wake(zeroed_cnt);
+	return page;
+}
+
+/* Gives pages from the top of PC back to POOL until only CNT
+   are left. */
+static void
+page_cache_shrink(struct pool *pool, struct page_cache *pc, size_t cnt)
+{
+	spin_lock(&pool->lock);
+	while (pc->cnt > cnt)
+	{
+		size_t page_idx = pg_no(pc->pages[--pc->cnt]) - pg_no(pool->base);
+		ASSERT(bitmap_test(pool->used_map, page_idx));
+		bitmap_reset(pool->used_map, page_idx);
+		buddy_free_range(pool, page_idx, 1);
+	}
+	spin_unlock(&pool->lock);
+}
+
+/* Puts PAGE, from POOL, in the running CPU's cache, first giving
+   a batch back to POOL if the cache is full.  Panics if PAGE is
+   already free, whether it went back to POOL or still sits in the
+   cache; this check stays in NDEBUG builds, where nothing else
+   would catch it before the page is handed out twice. */
+static void
+page_cache_put(struct pool *pool, void *page)
+{
+	enum intr_level old_level = intr_disable();
+	struct page_cache *pc = page_cache(pool);
+	size_t i;
+
+	if (!bitmap_test(pool->used_map, pg_no(page) - pg_no(pool->base)))
+		PANIC("palloc_free_page: double free of %p", page);
+	for (i = 0; i < pc->cnt; i++)
+		if (pc->pages[i] == page)
+			PANIC("palloc_free_page: double free of %p", page);
+
+	if (pc->cnt == PCP_HIGH)
+		page_cache_shrink(pool, pc, PCP_HIGH - PCP_BATCH);
+	pc->pages[pc->cnt++] = page;
+	intr_set_level(old_level);
+}
+
+/* Gives every page in the running CPU's cache for POOL back to
+   POOL. */
+static void
+page_cache_drain(struct pool *pool)
+{
+	enum intr_level old_level = intr_disable();
+	struct page_cache *pc = page_cache(pool);
+
+	page_cache_shrink(pool, pc, 0);
+	intr_set_level(old_level);
+}
+
+/* Pops a pre-zeroed page off POOL's zeroed stack, or returns a
+   null pointer if it is empty. */
+static void *
+zeroed_get(struct pool *pool)
+{
+	void *page = NULL;
+	size_t zeroed_cnt;
+
+	spin_lock(&pool->lock);
+	if (pool->zeroed_cnt > 0)
+		page = pool->zeroed[--pool->zeroed_cnt];
+	zeroed_cnt = pool->zeroed_cnt;
+	spin_unlock(&pool->lock);
+
+	zeroer_wake(zeroed_cnt);
+	return page;
+}
+
+/* Gives every page on POOL's zeroed stack back to the buddy
+   lists. */
+static void
+zeroed_drain(struct pool *pool)
+{
+	spin_lock(&pool->lock);
+	while (pool->zeroed_cnt > 0)
+	{
+		void *page = pool->zeroed[--pool->zeroed_cnt];
+		size_t page_idx = pg_no(page) - pg_no(pool->base);
+		bitmap_reset(pool->used_map, page_idx);
+		buddy_free_range(pool, page_idx, 1);
+	}
+	spin_unlock(&pool->lock);
+
+	zeroer_wake(0);
+}
+
+/* Wakes the zeroer if it is asleep and a zeroed stack was left
+   with ZEROED_CNT pages, which is low enough to refill. */
+static void
+zeroer_wake(size_t zeroed_cnt)
+{
+	if (zeroed_cnt <= ZERO_LOW
+		&& __atomic_exchange_n(&zeroer_asleep, false, __ATOMIC_ACQ_REL))
+		sema_up(&zero_sema);
+}
+
+/* Clears one free page of POOL and pushes it on the zeroed
+   stack.  Returns false if the stack is full or POOL has no free
+   page. */
+static bool
+zero_one(struct pool *pool)
+{
+	size_t page_idx = BITMAP_ERROR;
+	void *page;
+
+	spin_lock(&pool->lock);
+	if (pool->zeroed_cnt < ZERO_HIGH)
+	{
+		page_idx = buddy_alloc(pool, 1);
+		if (page_idx != BITMAP_ERROR)
+		{
+			ASSERT(!bitmap_test(pool->used_map, page_idx));
+			bitmap_mark(pool->used_map, page_idx);
+		}
+	}
+	spin_unlock(&pool->lock);
+	if (page_idx == BITMAP_ERROR)
+		return false;
+
+	/* The page is ours while we clear it, with interrupts on. */
+	page = pool->base + PGSIZE * page_idx;
+	memset(page, 0, PGSIZE);
+
+	/* Only we push, so there is still room. */
+	spin_lock(&pool->lock);
+	ASSERT(pool->zeroed_cnt < ZERO_HIGH);
+	pool->zeroed[pool->zeroed_cnt++] = page;
+	spin_unlock(&pool->lock);
+	return true;
+}
+
+/* Zeroer thread.  Runs at PRI_MIN, so it only clears pages when
+   nothing else wants the CPU, and sleeps once both zeroed stacks
+   are full. */
+static void
+zeroer(void *aux UNUSED)
+{
+	/* Under mlfqs PRI_MIN is meaningless; stay as nice as possible. */
+	if (thread_mlfqs)
+		thread_set_nice(NICE_MAX);
+
+	for (;;)
+	{
+		bool progress = zero_one(&kernel_pool);
+		progress |= zero_one(&user_pool);
+		if (progress)
+		{
+			thread_yield();
+			continue;
+		}
+
+		/* Announce that we are going to sleep, then look once more
+		   so that a stack drained in between is not missed. */
+		__atomic_store_n(&zeroer_asleep, true, __ATOMIC_SEQ_CST);
+		progress = zero_one(&kernel_pool);
+		progress |= zero_one(&user_pool);
+		if (progress && __atomic_exchange_n(&zeroer_asleep, false, __ATOMIC_ACQ_REL))
+			continue;
+
+		/* Either nothing to do, or someone already cleared the flag
+		   and ups (or has upped) zero_sema for us. */
+		sema_down(&zero_sema);
+	}
+}
+
+/* Starts the zeroer thread.  Called once thread_start() has
+   brought up the scheduler. */
+void palloc_start_zeroer(void)
+{
+	thread_create("zeroer", PRI_MIN, zeroer, NULL);
+}
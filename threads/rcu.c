@@ -0,0 +1,124 @@
+#include "threads/rcu.h"
+#include <debug.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Callbacks waiting for a grace period.
+   Protected by disabling interrupts. */
+static struct list rcu_callbacks;
+
+/* Initializes the RCU callback list.  Called by thread_init(). */
+void rcu_init(void)
+{
+	list_init(&rcu_callbacks);
+}
+
+/* Enters a read-side critical section.  Sections nest. */
+void rcu_read_lock(void)
+{
+	thread_current()->rcu_nesting++;
+	barrier();
+}
+
+/* Leaves a read-side critical section.  If a higher-priority
+   thread became ready while we were inside, yield to it now. */
+void rcu_read_unlock(void)
+{
+	struct thread *t = thread_current();
+
+	ASSERT(t->rcu_nesting > 0);
+	barrier();
+	if (--t->rcu_nesting == 0 && t->rcu_yield_deferred && !intr_context())
+	{
+		t->rcu_yield_deferred = false;
+		thread_yield();
+	}
+}
+
+/* Waits until every CPU has passed through a quiescent state, so
+   that no reader can still hold a reference to anything that was
+   unlinked before the call.
+
+   The calling CPU is quiescent already: we are running on it and
+   read sections cannot be preempted, so no reader is suspended
+   there.  With a single CPU this returns at once. */
+void synchronize_rcu(void)
+{
+	struct thread *t = thread_current();
+	unsigned long long snap[NCPU_MAX];
+	struct cpu *self;
+	enum intr_level old_level;
+	int i;
+
+	ASSERT(!intr_context());
+	ASSERT(t->rcu_nesting == 0);
+
+	old_level = intr_disable();
+	self = t->cpu;
+	for (i = 0; i < cpu_cnt; i++)
+		snap[i] = __atomic_load_n(&cpus[i].rcu_qs, __ATOMIC_RELAXED);
+	intr_set_level(old_level);
+
+	for (i = 0; i < cpu_cnt; i++)
+		while (&cpus[i] != self
+				&& __atomic_load_n(&cpus[i].rcu_qs, __ATOMIC_ACQUIRE) == snap[i])
+			thread_yield();
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/* Arranges for FUNC (HEAD) to be called after a grace period.
+   Never sleeps, so writers may call it while holding locks.
+
+   The reaper is woken only if it is idle in its wait loop.  FUNC
+   may sleep, so the reaper can be blocked on a lock inside an
+   earlier callback when we get here; it then finds HEAD on its
+   next pass instead. */
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *))
+{
+	enum intr_level old_level;
+
+	ASSERT(head != NULL);
+	ASSERT(func != NULL);
+
+	head->func = func;
+	old_level = intr_disable();
+	list_push_back(&rcu_callbacks, &head->elem);
+	intr_set_level(old_level);
+
+	thread_wake_reaper();
+}
+
+/* Returns true if call_rcu() callbacks are queued.
+   Interrupts must be off. */
+bool rcu_callbacks_pending(void)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	return !list_empty(&rcu_callbacks);
+}
+
+/* Waits for a grace period and runs every callback that was
+   queued before the call.  Called by the reaper thread. */
+void rcu_process_callbacks(void)
+{
+	struct list batch;
+	enum intr_level old_level;
+
+	list_init(&batch);
+	old_level = intr_disable();
+	while (!list_empty(&rcu_callbacks))
+		list_push_back(&batch, list_pop_front(&rcu_callbacks));
+	intr_set_level(old_level);
+
+	if (list_empty(&batch))
+		return;
+
+	synchronize_rcu();
+	while (!list_empty(&batch))
+	{
+		struct rcu_head *head = list_entry(list_pop_front(&batch),
+											struct rcu_head, elem);
+		head->func(head);
+	}
+}
@@ -0,0 +1,266 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator.
+
+   A cache hands out objects of one exact size, rounded up only
+   to SLAB_ALIGN, instead of the next power of 2 that malloc()
+   would use.  Its objects live in "slabs": single pages from the
+   page allocator that start with a struct slab header followed by
+   a free-list index per object and then the objects themselves.
+   The free list is kept in the header rather than in the free
+   objects, so an object returned to its cache keeps its
+   contents.
+
+   If the cache has a constructor, it runs once per object when a
+   slab is created, not on every allocation; objects must be
+   freed back in their constructed state.
+
+   The cache keeps the slabs that have free objects on its partial
+   list, partly used ones first so that empty slabs can drain.
+   Full slabs are on no list; kmem_cache_free() finds an object's
+   slab from its page.  At most SLAB_EMPTY_MAX empty slabs are
+   kept; further ones go back to the page allocator.
+
+   free() also accepts objects from a cache (see kmem_cache_of()),
+   so code that only has a void pointer does not need to know
+   which allocator it came from. */
+
+#define SLAB_ALIGN 8		/* Object alignment. */
+#define SLAB_EMPTY_MAX 1	/* Empty slabs kept per cache. */
+#define SLAB_END UINT16_MAX /* End of a slab's free list. */
+
+/* Magic number for detecting slab pages and corruption. */
+#define SLAB_MAGIC 0x51ab0bec
+
+/* Object cache. */
+struct kmem_cache
+{
+	const char *name;	   /* Name, for statistics. */
+	size_t obj_size;	   /* Object size, rounded to SLAB_ALIGN. */
+	size_t objs_per_slab;  /* Objects in a slab. */
+	size_t obj_ofs;		   /* Offset of the first object in a slab. */
+	void (*ctor)(void *);  /* Constructor, or null. */
+	struct mutex lock;	   /* Protects the members below. */
+	struct list partial;   /* Slabs with free objects. */
+	size_t empty_cnt;	   /* Slabs in partial with no objects in use. */
+	struct list_elem elem; /* Element in all_caches. */
+
+	/* Statistics. */
+	size_t slab_cnt;	   /* Slabs owned. */
+	size_t active_cnt;	   /* Objects in use. */
+	size_t peak_cnt;	   /* Highest active_cnt so far. */
+	long long alloc_cnt;   /* kmem_cache_alloc() calls. */
+};
+
+/* Slab header, at the start of each slab page. */
+struct slab
+{
+	unsigned magic;			  /* Always SLAB_MAGIC.  Must come first. */
+	struct kmem_cache *cache; /* Owning cache. */
+	struct list_elem elem;	  /* Element in cache's partial list. */
+	size_t in_use;			  /* Objects in use. */
+	uint16_t free;			  /* First free object, or SLAB_END. */
+	uint16_t next[];		  /* Per object: next free object. */
+};
+
+/* All caches, for kmem_print_stats(). */
+static struct list all_caches;
+static struct lock all_caches_lock;
+
+/* Initializes the slab allocator. */
+void slab_init(void)
+{
+	list_init(&all_caches);
+	lock_init(&all_caches_lock);
+}
+
+/* Creates a cache of SIZE-byte objects named NAME.  CTOR, if not
+   null, is called on each object when its slab is created.
+   Returns a null pointer if memory is not available. */
+struct kmem_cache *
+kmem_cache_create(const char *name, size_t size, void (*ctor)(void *))
+{
+	struct kmem_cache *c;
+	size_t objs;
+
+	ASSERT(name != NULL);
+	ASSERT(size > 0);
+
+	size = ROUND_UP(size, SLAB_ALIGN);
+	objs = (PGSIZE - sizeof(struct slab)) / (size + sizeof(uint16_t));
+	while (objs > 0
+		   && ROUND_UP(sizeof(struct slab) + objs * sizeof(uint16_t), SLAB_ALIGN) + objs * size > PGSIZE)
+		objs--;
+	ASSERT(objs > 0 && objs < SLAB_END);
+
+	c = malloc(sizeof *c);
+	if (c == NULL)
+		return NULL;
+	c->name = name;
+	c->obj_size = size;
+	c->objs_per_slab = objs;
+	c->obj_ofs = ROUND_UP(sizeof(struct slab) + objs * sizeof(uint16_t), SLAB_ALIGN);
+	c->ctor = ctor;
+	mutex_init(&c->lock);
+	list_init(&c->partial);
+	c->empty_cnt = 0;
+	c->slab_cnt = c->active_cnt = c->peak_cnt = 0;
+	c->alloc_cnt = 0;
+
+	lock_acquire(&all_caches_lock);
+	list_push_back(&all_caches, &c->elem);
+	lock_release(&all_caches_lock);
+	return c;
+}
+
+/* Returns the IDX'th object of slab S in cache C. */
+static void *
+slab_obj(struct kmem_cache *c, struct slab *s, size_t idx)
+{
+	return (uint8_t *)s + c->obj_ofs + idx * c->obj_size;
+}
+
+/* Creates a new, empty slab for C and puts it on C's partial
+   list.  Returns false if no page is available. */
+static bool
+slab_grow(struct kmem_cache *c)
+{
+	struct slab *s = palloc_get_page(0);
+	size_t i;
+
+	if (s == NULL)
+		return false;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->in_use = 0;
+	s->free = 0;
+	for (i = 0; i < c->objs_per_slab; i++)
+	{
+		s->next[i] = i + 1 < c->objs_per_slab ? i + 1 : SLAB_END;
+		if (c->ctor != NULL)
+			c->ctor(slab_obj(c, s, i));
+	}
+
+	list_push_back(&c->partial, &s->elem);
+	c->empty_cnt++;
+	c->slab_cnt++;
+	return true;
+}
+
+/* Allocates an object from C.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc(struct kmem_cache *c)
+{
+	struct slab *s;
+	size_t idx;
+
+	ASSERT(c != NULL);
+
+	mutex_acquire(&c->lock);
+	if (list_empty(&c->partial) && !slab_grow(c))
+	{
+		mutex_release(&c->lock);
+		return NULL;
+	}
+
+	s = list_entry(list_front(&c->partial), struct slab, elem);
+	if (s->in_use++ == 0)
+		c->empty_cnt--;
+	idx = s->free;
+	s->free = s->next[idx];
+	if (s->free == SLAB_END)
+		list_remove(&s->elem);
+
+	c->alloc_cnt++;
+	if (++c->active_cnt > c->peak_cnt)
+		c->peak_cnt = c->active_cnt;
+	mutex_release(&c->lock);
+
+	return slab_obj(c, s, idx);
+}
+
+/* Returns OBJ, which must have been allocated from C, to C. */
+void kmem_cache_free(struct kmem_cache *c, void *obj)
+{
+	struct slab *s;
+	size_t idx;
+
+	if (obj == NULL)
+		return;
+
+	s = pg_round_down(obj);
+	ASSERT(s->magic == SLAB_MAGIC);
+	ASSERT(s->cache == c);
+	idx = ((uint8_t *)obj - (uint8_t *)s - c->obj_ofs) / c->obj_size;
+	ASSERT(slab_obj(c, s, idx) == obj);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs, unless
+	   it has to keep its constructed state. */
+	if (c->ctor == NULL)
+		memset(obj, 0xcc, c->obj_size);
+#endif
+
+	mutex_acquire(&c->lock);
+	if (s->free == SLAB_END)
+		list_push_front(&c->partial, &s->elem);
+	s->next[idx] = s->free;
+	s->free = idx;
+	c->active_cnt--;
+
+	if (--s->in_use == 0)
+	{
+		list_remove(&s->elem);
+		if (c->empty_cnt >= SLAB_EMPTY_MAX)
+		{
+			c->slab_cnt--;
+			palloc_free_page(s);
+		}
+		else
+		{
+			list_push_back(&c->partial, &s->elem);
+			c->empty_cnt++;
+		}
+	}
+	mutex_release(&c->lock);
+}
+
+/* Returns the cache that OBJ was allocated from, or a null
+   pointer if OBJ did not come from a slab cache.  OBJ must have
+   come from kmem_cache_alloc() or malloc(), both of which put a
+   header with a magic number at the start of the page. */
+struct kmem_cache *
+kmem_cache_of(const void *obj)
+{
+	const struct slab *s = pg_round_down(obj);
+	return s->magic == SLAB_MAGIC ? s->cache : NULL;
+}
+
+/* Prints slab allocator statistics. */
+void kmem_print_stats(void)
+{
+	struct list_elem *e;
+
+	lock_acquire(&all_caches_lock);
+	for (e = list_begin(&all_caches); e != list_end(&all_caches); e = list_next(e))
+	{
+		struct kmem_cache *c = list_entry(e, struct kmem_cache, elem);
+		printf("Slab %s: %zu-byte objects, %zu in use (peak %zu), "
+			   "%zu slabs of %zu, %lld allocations\n",
+			   c->name, c->obj_size, c->active_cnt, c->peak_cnt,
+			   c->slab_cnt, c->objs_per_slab, c->alloc_cnt);
+	}
+	lock_release(&all_caches_lock);
+}
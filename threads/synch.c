@@ -31,6 +31,9 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef LOCK_PROFILE
+#include "devices/timer.h"
+#endif
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -47,6 +50,27 @@ void sema_init(struct semaphore *sema, unsigned value)
 
 	sema->value = value;
 	list_init(&sema->waiters);
+	sema->owner = NULL;
+}
+
+static void lock_refresh_max_priority(struct lock *);
+static void waiter_reorder(struct thread *);
+
+/* Raises SEMA's owner, if any, to the priority of its best
+   waiter.  Interrupts must be off. */
+static void
+sema_donate(struct semaphore *sema)
+{
+	int priority;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (thread_mlfqs || sema->owner == NULL || list_empty(&sema->waiters))
+		return;
+
+	/* waiters는 우선순위 순으로 정렬되어 있으므로 맨 앞이 최댓값 */
+	priority = list_entry(list_front(&sema->waiters), struct thread, elem)->priority;
+	if (sema->owner->priority < priority)
+		thread_set_effective_priority(sema->owner, priority);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -71,7 +95,11 @@ void sema_down(struct semaphore *sema)
 	old_level = intr_disable();
 	while (sema->value == 0)
 	{
+		/* 대기 중 우선순위가 바뀌면 sema_waiter_reposition()이
+		 * 제자리로 옮겨 주므로 waiters는 항상 정렬되어 있다. */
 		list_insert_ordered(&sema->waiters, &thread_current()->elem, cmp_priority, NULL);
+		thread_current()->waiting_sema = sema;
+		sema_donate(sema);
 		thread_block();
 	}
 	sema->value--;
@@ -111,7 +139,7 @@ void sema_up(struct semaphore *sema)
 {
 
 	/* Project2 - Priority Scheduling
-	 * waiter list에 있는 쓰레드의 우선순위가 변경 되었을 경우를 고려하여 waiter list를 정렬 (list_sort)
+	 * waiters는 우선순위 순으로 유지되므로 맨 앞의 스레드를 깨운다
 	 * 세마포어 해제 후 priority preemption 기능 추가
 	 */
 	enum intr_level old_level;
@@ -121,14 +149,66 @@ void sema_up(struct semaphore *sema)
 	old_level = intr_disable();
 	if (!list_empty(&sema->waiters))
 	{
-		list_sort(&sema->waiters, cmp_priority, NULL);
-		thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
+		struct thread *t = list_entry(list_pop_front(&sema->waiters), struct thread, elem);
+		t->waiting_sema = NULL;
+		thread_unblock(t);
 	}
 	sema->value++;
+	/* 깨운 스레드에게 받은 기부를 owner에게서 되돌린다.
+	 * owner가 아닌 스레드가 up 해도, block된 owner의 우선순위가 내려가면
+	 * owner가 기다리는 lock의 holder까지 다시 계산된다. */
+	if (sema->owner != NULL && !thread_mlfqs)
+		thread_set_effective_priority(sema->owner, thread_donated_priority(sema->owner));
 	test_max_priority();
 	intr_set_level(old_level);
 }
 
+/* Makes OWNER, which may be NULL, the thread expected to up SEMA.
+   Current waiters donate to the new owner at once.  The owner
+   must clear itself (or be cleared) before SEMA's memory goes
+   away; thread_exit() drops everything the thread owns. */
+void sema_set_owner(struct semaphore *sema, struct thread *owner)
+{
+	struct thread *old_owner;
+	enum intr_level old_level;
+
+	ASSERT(sema != NULL);
+
+	old_level = intr_disable();
+	old_owner = sema->owner;
+	if (old_owner != NULL)
+		list_remove(&sema->owner_elem);
+	sema->owner = owner;
+	if (owner != NULL)
+	{
+		list_push_back(&owner->owned_semas, &sema->owner_elem);
+		sema_donate(sema);
+	}
+	if (old_owner != NULL && !intr_context() && old_owner == thread_current() && !thread_mlfqs)
+		refresh_priority();
+	intr_set_level(old_level);
+}
+
+/* Returns the highest priority among threads waiting on any
+   semaphore that T owns, or PRI_MIN - 1 if there are none. */
+int sema_donated_priority(struct thread *t)
+{
+	int priority = PRI_MIN - 1;
+	struct list_elem *e;
+
+	for (e = list_begin(&t->owned_semas); e != list_end(&t->owned_semas); e = list_next(e))
+	{
+		struct semaphore *sema = list_entry(e, struct semaphore, owner_elem);
+		if (!list_empty(&sema->waiters))
+		{
+			int p = list_entry(list_front(&sema->waiters), struct thread, elem)->priority;
+			if (p > priority)
+				priority = p;
+		}
+	}
+	return priority;
+}
+
 static void sema_test_helper(void *sema_);
 
 /* Self-test for semaphores that makes control "ping-pong"
@@ -180,12 +260,186 @@ sema_test_helper(void *sema_)
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
-void lock_init(struct lock *lock)
+/* With LOCK_PROFILE, lock_init() is a macro that records the call
+   site; the parentheses keep it from expanding here. */
+void(lock_init)(struct lock *lock)
 {
 	ASSERT(lock != NULL);
 
 	lock->holder = NULL;
+	lock->max_priority = PRI_MIN - 1;
 	sema_init(&lock->semaphore, 1);
+#ifdef LOCK_PROFILE
+	lock->site = NULL;
+	lock->acquired_at = 0;
+#endif
+}
+
+#ifdef LOCK_PROFILE
+/* Per-site statistics.  Sites beyond LOCK_SITE_MAX are counted
+   together in lock_site_other. */
+#define LOCK_SITE_MAX 128
+static struct lock_site lock_sites[LOCK_SITE_MAX];
+static int lock_site_cnt;
+static struct lock_site lock_site_other = {.file = "(other sites)"};
+
+/* Initializes LOCK like lock_init(), attributing its statistics
+   to FILE:LINE.  Sites are matched by the contents of FILE, since
+   the same file name may be stored more than once. */
+void lock_init_at(struct lock *lock, const char *file, int line)
+{
+	struct lock_site *site = NULL;
+	enum intr_level old_level;
+
+	(lock_init)(lock);
+
+	old_level = intr_disable();
+	for (int i = 0; i < lock_site_cnt; i++)
+		if (lock_sites[i].line == line && !strcmp(lock_sites[i].file, file))
+		{
+			site = &lock_sites[i];
+			break;
+		}
+	if (site == NULL && lock_site_cnt < LOCK_SITE_MAX)
+	{
+		site = &lock_sites[lock_site_cnt++];
+		site->file = file;
+		site->line = line;
+	}
+	lock->site = site != NULL ? site : &lock_site_other;
+	intr_set_level(old_level);
+}
+
+/* Records that the current thread got LOCK after waiting
+   WAIT_TICKS, which only counts as contention if CONTENDED. */
+static void
+lock_profile_acquired(struct lock *lock, bool contended, int64_t wait_ticks)
+{
+	struct lock_site *site = lock->site;
+	enum intr_level old_level = intr_disable();
+
+	lock->acquired_at = timer_ticks();
+	if (site != NULL)
+	{
+		site->acquires++;
+		if (contended)
+		{
+			site->contended++;
+			site->wait_ticks += wait_ticks;
+		}
+	}
+	intr_set_level(old_level);
+}
+
+/* Records that LOCK is about to be released. */
+static void
+lock_profile_released(struct lock *lock)
+{
+	struct lock_site *site = lock->site;
+	int64_t held = timer_ticks() - lock->acquired_at;
+	enum intr_level old_level = intr_disable();
+
+	if (site != NULL && held > site->max_hold_ticks)
+		site->max_hold_ticks = held;
+	intr_set_level(old_level);
+}
+
+/* Prints the statistics of every lock_init() site that was used. */
+void lock_print_stats(void)
+{
+	printf("Lock profile (site: acquires, contended, wait ticks, max hold ticks):\n");
+	for (int i = 0; i < lock_site_cnt; i++)
+	{
+		struct lock_site *site = &lock_sites[i];
+		if (site->acquires == 0)
+			continue;
+		printf("  %s:%d: %llu, %llu, %lld, %lld\n",
+			   site->file, site->line, site->acquires, site->contended,
+			   site->wait_ticks, site->max_hold_ticks);
+	}
+	if (lock_site_other.acquires != 0)
+		printf("  %s: %llu, %llu, %lld, %lld\n",
+			   lock_site_other.file, lock_site_other.acquires,
+			   lock_site_other.contended, lock_site_other.wait_ticks,
+			   lock_site_other.max_hold_ticks);
+}
+#endif /* LOCK_PROFILE */
+
+/* Resets LOCK's max_priority to the priority of its best
+   waiter, after a waiter's priority changed in either direction,
+   and recomputes the holder's priority from scratch.  If that
+   holder is blocked on another lock, the change is passed on to
+   that lock in turn, for at most DONATION_DEPTH_MAX locks, as
+   donate_priority() does.  Interrupts must be off. */
+static void
+lock_refresh_max_priority(struct lock *lock)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (thread_mlfqs)
+		return;
+
+	for (int depth = 0; lock != NULL && depth < DONATION_DEPTH_MAX; depth++)
+	{
+		struct list *waiters = &lock->semaphore.waiters;
+		struct thread *holder = lock->holder;
+		int priority;
+
+		if (holder == NULL)
+			return;
+
+		priority = list_empty(waiters)
+					   ? PRI_MIN - 1
+					   : list_entry(list_front(waiters), struct thread, elem)->priority;
+		if (priority == lock->max_priority)
+			return;
+
+		lock->max_priority = priority;
+		list_remove(&lock->elem);
+		list_insert_ordered(&holder->held_locks, &lock->elem, cmp_lock_priority, NULL);
+
+		priority = thread_donated_priority(holder);
+		if (priority == holder->priority)
+			return;
+		if (holder->status != THREAD_BLOCKED)
+		{
+			thread_set_effective_priority(holder, priority);
+			return;
+		}
+
+		/* Reorder the waiters the holder sits in here rather than
+		   through sema_waiter_reposition(), which would call back
+		   into this function. */
+		holder->priority = priority;
+		waiter_reorder(holder);
+		lock = holder->wait_on_lock;
+		if (lock != NULL && holder->waiting_sema != &lock->semaphore)
+			lock = NULL;
+	}
+}
+
+/* Makes the current thread the holder of LOCK, whose semaphore it
+   has just downed.  Under the priority scheduler the lock joins the
+   holder's held_locks, keyed by the best of its remaining waiters
+   (the front of the priority-ordered waiter list). */
+static void
+lock_take(struct lock *lock)
+{
+	struct thread *t = thread_current();
+	enum intr_level old_level = intr_disable();
+
+	lock->holder = t;
+	if (!thread_mlfqs)
+	{
+		struct list *waiters = &lock->semaphore.waiters;
+
+		lock->max_priority = list_empty(waiters)
+								 ? PRI_MIN - 1
+								 : list_entry(list_front(waiters), struct thread, elem)->priority;
+		list_insert_ordered(&t->held_locks, &lock->elem, cmp_lock_priority, NULL);
+		if (lock->max_priority > t->priority)
+			t->priority = lock->max_priority;
+	}
+	intr_set_level(old_level);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -198,41 +452,39 @@ void lock_init(struct lock *lock)
    we need to sleep. */
 void lock_acquire(struct lock *lock)
 {
+	struct thread *t = thread_current();
+
+	ASSERT(lock != NULL);
+	ASSERT(!intr_context());
+	ASSERT(!lock_held_by_current_thread(lock));
+
+#ifdef LOCK_PROFILE
+	bool contended = lock->holder != NULL;
+	int64_t wait_start = timer_ticks();
+#endif
+
 	/*
 	 * project 1 - Priority Donation
-	 * lock을 점유하고 있는 스레드와 요청 하는 스레드의 우선순위를 비교하여
-	 * priority donation을 수행하도록 수정
+	 * lock을 점유하고 있는 스레드가 있으면 wait_on_lock을 기록하고
+	 * lock chain을 따라 priority donation을 수행
 	 */
 	if (!thread_mlfqs)
 	{
-		struct thread *t = thread_current();
-
+		enum intr_level old_level = intr_disable();
 		if (lock->holder != NULL)
 		{
 			t->wait_on_lock = lock;
-
-			if (lock->holder->priority < t->priority)
-			{
-				list_push_back(&(lock->holder->donations), &t->d_elem);
-				donate_priority();
-			}
+			donate_priority();
 		}
-
-		ASSERT(lock != NULL);
-		ASSERT(!intr_context());
-		ASSERT(!lock_held_by_current_thread(lock));
-
-		sema_down(&lock->semaphore);
-		lock->holder = t;
-		t->wait_on_lock = NULL;
-
-		return;
+		intr_set_level(old_level);
 	}
-	enum intr_level old_level = intr_disable();
+
 	sema_down(&lock->semaphore);
-	lock->holder = thread_current();
-	intr_set_level(old_level);
-	return;
+	t->wait_on_lock = NULL;
+	lock_take(lock);
+#ifdef LOCK_PROFILE
+	lock_profile_acquired(lock, contended, timer_ticks() - wait_start);
+#endif
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -250,7 +502,12 @@ bool lock_try_acquire(struct lock *lock)
 
 	success = sema_try_down(&lock->semaphore);
 	if (success)
-		lock->holder = thread_current();
+	{
+		lock_take(lock);
+#ifdef LOCK_PROFILE
+		lock_profile_acquired(lock, false, 0);
+#endif
+	}
 	return success;
 }
 
@@ -263,25 +520,26 @@ bool lock_try_acquire(struct lock *lock)
 
 void lock_release(struct lock *lock)
 {
-	/* donation list 에서 스레드를 제거하고 우선순위를 다시 계산하도록
-	 * remove_with_lock(), refresh_prioriy() 함수를 호출
-	 */
-	if (!thread_mlfqs)
-	{
-		ASSERT(lock != NULL);
-		ASSERT(lock_held_by_current_thread(lock));
+	enum intr_level old_level;
 
-		remove_with_lock(lock);
-		refresh_priority();
+	ASSERT(lock != NULL);
+	ASSERT(lock_held_by_current_thread(lock));
 
-		lock->holder = NULL;
-		sema_up(&lock->semaphore);
+#ifdef LOCK_PROFILE
+	lock_profile_released(lock);
+#endif
 
-		return;
+	/* lock을 held_locks에서 빼고, 남은 lock들 중 가장 높은
+	 * max_priority로 우선순위를 다시 계산 (refresh_priority) */
+	old_level = intr_disable();
+	if (!thread_mlfqs)
+	{
+		list_remove(&lock->elem);
+		lock->max_priority = PRI_MIN - 1;
+		refresh_priority();
 	}
-	enum intr_level old_level = intr_disable();
-	sema_up(&lock->semaphore);
 	lock->holder = NULL;
+	sema_up(&lock->semaphore);
 	intr_set_level(old_level);
 }
 
@@ -295,11 +553,432 @@ bool lock_held_by_current_thread(const struct lock *lock)
 	return lock->holder == thread_current();
 }
 
+/* Maximum number of times mutex_acquire() polls a running holder
+   before giving up and blocking. */
+#define MUTEX_SPIN_MAX 1000
+
+/* Initializes MUTEX as released.  With LOCK_PROFILE, mutex_init()
+   is a macro like lock_init(). */
+void(mutex_init)(struct mutex *mutex)
+{
+	ASSERT(mutex != NULL);
+
+	lock_init(&mutex->lock);
+}
+
+/* Acquires MUTEX.  While the holder is running on another CPU it
+   is likely to release the mutex soon, so spin instead of paying
+   for two context switches.  If the holder is not running (which
+   is always the case on a single CPU), or it keeps the mutex for
+   more than MUTEX_SPIN_MAX polls, fall back to lock_acquire(),
+   which blocks and donates priority as usual.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void mutex_acquire(struct mutex *mutex)
+{
+	ASSERT(mutex != NULL);
+	ASSERT(!intr_context());
+	ASSERT(!mutex_held_by_current_thread(mutex));
+
+	for (int spin = 0; spin < MUTEX_SPIN_MAX; spin++)
+	{
+		struct thread *holder =
+			__atomic_load_n(&mutex->lock.holder, __ATOMIC_ACQUIRE);
+
+		if (holder == NULL)
+		{
+			if (lock_try_acquire(&mutex->lock))
+				return;
+		}
+		else if (__atomic_load_n(&holder->status, __ATOMIC_RELAXED) != THREAD_RUNNING)
+			break;
+		asm volatile("pause");
+	}
+	lock_acquire(&mutex->lock);
+}
+
+/* Tries to acquire MUTEX without spinning or sleeping.
+   Returns true if successful. */
+bool mutex_try_acquire(struct mutex *mutex)
+{
+	ASSERT(mutex != NULL);
+
+	return lock_try_acquire(&mutex->lock);
+}
+
+/* Releases MUTEX, which must be owned by the current thread. */
+void mutex_release(struct mutex *mutex)
+{
+	ASSERT(mutex != NULL);
+
+	lock_release(&mutex->lock);
+}
+
+/* Returns true if the current thread holds MUTEX. */
+bool mutex_held_by_current_thread(const struct mutex *mutex)
+{
+	ASSERT(mutex != NULL);
+
+	return lock_held_by_current_thread(&mutex->lock);
+}
+
+static struct rw_hold *rw_hold_slot(struct thread *);
+static void rw_hold_add(struct thread *, struct rwlock *);
+static void rw_hold_remove(struct thread *, struct rwlock *);
+static void rw_donate(struct rwlock *, int depth);
+static void rw_grant(struct rwlock *);
+
+/* Initializes reader-writer lock RW as released. */
+void rw_init(struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	rw->readers = 0;
+	rw->writer = NULL;
+	list_init(&rw->holders);
+	list_init(&rw->read_waiters);
+	list_init(&rw->write_waiters);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.  A thread must not acquire RW for reading
+   twice: a writer arriving in between would deadlock it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rw_read_acquire(struct rwlock *rw)
+{
+	struct thread *cur = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+	ASSERT(rw->writer != cur);
+	ASSERT(rw_hold_slot(cur) != NULL);
+
+	old_level = intr_disable();
+	if (rw->writer != NULL || !list_empty(&rw->write_waiters))
+	{
+		list_push_back(&rw->read_waiters, &cur->elem);
+		cur->waiting_rw = rw;
+		rw_donate(rw, 0);
+		thread_block(); /* rw_grant() hands us the lock. */
+	}
+	else
+	{
+		rw->readers++;
+		rw_hold_add(cur, rw);
+	}
+	intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void rw_read_release(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw->readers > 0);
+
+	old_level = intr_disable();
+	rw_hold_remove(thread_current(), rw);
+	rw->readers--;
+	if (!thread_mlfqs)
+		refresh_priority();
+	if (rw->readers == 0)
+		rw_grant(rw);
+	test_max_priority();
+	intr_set_level(old_level);
+}
+
+/* Acquires RW for writing, sleeping while anyone else holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rw_write_acquire(struct rwlock *rw)
+{
+	struct thread *cur = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(!intr_context());
+	ASSERT(rw->writer != cur);
+	ASSERT(rw_hold_slot(cur) != NULL);
+
+	old_level = intr_disable();
+	if (rw->writer != NULL || rw->readers > 0)
+	{
+		list_push_back(&rw->write_waiters, &cur->elem);
+		cur->waiting_rw = rw;
+		rw_donate(rw, 0);
+		thread_block(); /* rw_grant() hands us the lock. */
+	}
+	else
+	{
+		rw->writer = cur;
+		rw_hold_add(cur, rw);
+	}
+	intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void rw_write_release(struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT(rw != NULL);
+	ASSERT(rw_write_held_by_current_thread(rw));
+
+	old_level = intr_disable();
+	rw_hold_remove(thread_current(), rw);
+	rw->writer = NULL;
+	if (!thread_mlfqs)
+		refresh_priority();
+	rw_grant(rw);
+	test_max_priority();
+	intr_set_level(old_level);
+}
+
+/* Returns true if the current thread holds RW for writing. */
+bool rw_write_held_by_current_thread(const struct rwlock *rw)
+{
+	ASSERT(rw != NULL);
+
+	return rw->writer == thread_current();
+}
+
+/* Returns the highest priority among threads waiting on any
+   rwlock that T holds, or PRI_MIN - 1 if there are none. */
+int rw_donated_priority(struct thread *t)
+{
+	int priority = PRI_MIN - 1;
+
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+	{
+		struct rwlock *rw = t->rw_holds[i].lock;
+		struct list_elem *e;
+
+		if (rw == NULL)
+			continue;
+		for (e = list_begin(&rw->read_waiters); e != list_end(&rw->read_waiters); e = list_next(e))
+			if (list_entry(e, struct thread, elem)->priority > priority)
+				priority = list_entry(e, struct thread, elem)->priority;
+		for (e = list_begin(&rw->write_waiters); e != list_end(&rw->write_waiters); e = list_next(e))
+			if (list_entry(e, struct thread, elem)->priority > priority)
+				priority = list_entry(e, struct thread, elem)->priority;
+	}
+	return priority;
+}
+
+/* Returns an unused rw_hold of T, or a null pointer if T
+   already holds RW_HOLD_MAX rwlocks. */
+static struct rw_hold *
+rw_hold_slot(struct thread *t)
+{
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+		if (t->rw_holds[i].lock == NULL)
+			return &t->rw_holds[i];
+	return NULL;
+}
+
+/* Records that T now holds RW.  The acquire functions have
+   checked that T has a slot left. */
+static void
+rw_hold_add(struct thread *t, struct rwlock *rw)
+{
+	struct rw_hold *h = rw_hold_slot(t);
+
+	ASSERT(h != NULL);
+	h->lock = rw;
+	h->thread = t;
+	list_push_back(&rw->holders, &h->elem);
+}
+
+/* Forgets that T holds RW. */
+static void
+rw_hold_remove(struct thread *t, struct rwlock *rw)
+{
+	for (int i = 0; i < RW_HOLD_MAX; i++)
+	{
+		struct rw_hold *h = &t->rw_holds[i];
+		if (h->lock == rw)
+		{
+			list_remove(&h->elem);
+			h->lock = NULL;
+			return;
+		}
+	}
+}
+
+/* Raises every holder of RW to the priority of its best waiter.
+   A blocked writer thereby donates to all current readers.  A
+   raised holder that is itself blocked on a lock or rwlock passes
+   the donation on, as donate_priority() does; DEPTH links have
+   been followed already, and at most DONATION_DEPTH_MAX are. */
+static void
+rw_donate(struct rwlock *rw, int depth)
+{
+	struct list_elem *e;
+	int priority = PRI_MIN - 1;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (thread_mlfqs)
+		return;
+
+	for (e = list_begin(&rw->read_waiters); e != list_end(&rw->read_waiters); e = list_next(e))
+		if (list_entry(e, struct thread, elem)->priority > priority)
+			priority = list_entry(e, struct thread, elem)->priority;
+	for (e = list_begin(&rw->write_waiters); e != list_end(&rw->write_waiters); e = list_next(e))
+		if (list_entry(e, struct thread, elem)->priority > priority)
+			priority = list_entry(e, struct thread, elem)->priority;
+
+	for (e = list_begin(&rw->holders); e != list_end(&rw->holders); e = list_next(e))
+	{
+		struct thread *holder = list_entry(e, struct rw_hold, elem)->thread;
+		if (holder->priority >= priority)
+			continue;
+		thread_set_effective_priority(holder, priority);
+		if (depth + 1 >= DONATION_DEPTH_MAX)
+			continue;
+		if (holder->wait_on_lock != NULL)
+			donate_priority_chain(holder->wait_on_lock, priority, depth + 1);
+		else if (holder->waiting_rw != NULL)
+			rw_donate(holder->waiting_rw, depth + 1);
+	}
+}
+
+/* Hands RW, which nobody holds any more, to its waiters: the
+   highest-priority writer if there is one, else every reader. */
+static void
+rw_grant(struct rwlock *rw)
+{
+	struct thread *t;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(rw->writer == NULL);
+
+	if (rw->readers > 0)
+		return;
+
+	if (!list_empty(&rw->write_waiters))
+	{
+		struct list_elem *e = list_min(&rw->write_waiters, cmp_priority, NULL);
+		list_remove(e);
+		t = list_entry(e, struct thread, elem);
+		rw->writer = t;
+		rw_hold_add(t, rw);
+		t->waiting_rw = NULL;
+		thread_unblock(t);
+	}
+	else
+		while (!list_empty(&rw->read_waiters))
+		{
+			t = list_entry(list_pop_front(&rw->read_waiters), struct thread, elem);
+			rw->readers++;
+			rw_hold_add(t, rw);
+			t->waiting_rw = NULL;
+			thread_unblock(t);
+		}
+
+	/* The remaining waiters now wait on the new holders. */
+	rw_donate(rw, 0);
+}
+
+/* Initializes spin lock LOCK as released. */
+void spin_lock_init(struct spinlock *lock)
+{
+	ASSERT(lock != NULL);
+
+	lock->locked = 0;
+	lock->old_level = INTR_OFF;
+}
+
+/* Acquires spin lock LOCK, busy-waiting until it is released by
+   whichever CPU holds it.  Disables interrupts on this CPU until
+   the matching spin_unlock(), so that an interrupt handler on
+   this CPU cannot spin on a lock its own CPU holds.
+
+   Spin locks may be nested but must be released in the reverse
+   order of acquisition. */
+void spin_lock(struct spinlock *lock)
+{
+	enum intr_level old_level;
+
+	ASSERT(lock != NULL);
+
+	old_level = intr_disable();
+	while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE))
+		while (lock->locked)
+			asm volatile("pause");
+	lock->old_level = old_level;
+}
+
+/* Releases spin lock LOCK and restores the interrupt level that
+   was in effect when it was acquired. */
+void spin_unlock(struct spinlock *lock)
+{
+	enum intr_level old_level;
+
+	ASSERT(lock != NULL);
+	ASSERT(lock->locked);
+
+	old_level = lock->old_level;
+	__atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+	intr_set_level(old_level);
+}
+
+/* Initializes sequence lock SL. */
+void seqlock_init(struct seqlock *sl)
+{
+	ASSERT(sl != NULL);
+
+	sl->seq = 0;
+	spin_lock_init(&sl->lock);
+}
+
+/* Starts a read section of SL and returns the sequence number to
+   pass to read_seqretry().  Waits out a write in progress on
+   another CPU. */
+unsigned read_seqbegin(const struct seqlock *sl)
+{
+	unsigned seq;
+
+	while ((seq = __atomic_load_n(&sl->seq, __ATOMIC_ACQUIRE)) & 1)
+		asm volatile("pause");
+	return seq;
+}
+
+/* Returns true if a writer changed SL since read_seqbegin()
+   returned START, in which case the values read must be
+   discarded and read again. */
+bool read_seqretry(const struct seqlock *sl, unsigned start)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&sl->seq, __ATOMIC_RELAXED) != start;
+}
+
+/* Starts a write section of SL. */
+void write_seqlock(struct seqlock *sl)
+{
+	spin_lock(&sl->lock);
+	__atomic_store_n(&sl->seq, sl->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/* Ends a write section of SL. */
+void write_sequnlock(struct seqlock *sl)
+{
+	__atomic_store_n(&sl->seq, sl->seq + 1, __ATOMIC_RELEASE);
+	spin_unlock(&sl->lock);
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem
 {
 	struct list_elem elem;		/* List element. */
 	struct semaphore semaphore; /* This semaphore. */
+	struct thread *thread;		/* Waiting thread. */
 };
 
 /* Initializes condition variable COND.  A condition variable
@@ -345,8 +1024,14 @@ void cond_wait(struct condition *cond, struct lock *lock)
 	ASSERT(lock_held_by_current_thread(lock));
 
 	// condition variable의 waiters list에 우선순위로 삽입
+	struct thread *cur = thread_current();
+	enum intr_level old_level = intr_disable();
 	sema_init(&waiter.semaphore, 0);
+	waiter.thread = cur;
 	list_insert_ordered(&cond->waiters, &waiter.elem, cmp_sem_priority, NULL);
+	cur->waiting_cond = cond;
+	cur->cond_elem = &waiter.elem;
+	intr_set_level(old_level);
 
 	// sema_down 에서 block 될 수 있기 때문에 다른 쓰레드가 사용할 수 있게 lock을 해제한다.
 	lock_release(lock);
@@ -365,19 +1050,23 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED)
 {
 
 	/* Project1 - Priority Scheduling
-	 * condition variable의 waiters list를 우선순위로 재정렬
-	 * 대기 중에 우선순위가 변경되었을 가능성이 있음
+	 * condition variable의 waiters list는 우선순위 순으로 유지되므로
+	 * 맨 앞의 waiter를 깨운다
 	 */
 	ASSERT(cond != NULL);
 	ASSERT(lock != NULL);
 	ASSERT(!intr_context());
 	ASSERT(lock_held_by_current_thread(lock));
 
+	enum intr_level old_level = intr_disable();
 	if (!list_empty(&cond->waiters))
 	{
-		list_sort(&cond->waiters, cmp_sem_priority, NULL);
-		sema_up(&list_entry(list_pop_front(&cond->waiters), struct semaphore_elem, elem)->semaphore);
+		struct semaphore_elem *waiter =
+			list_entry(list_pop_front(&cond->waiters), struct semaphore_elem, elem);
+		waiter->thread->waiting_cond = NULL;
+		sema_up(&waiter->semaphore);
 	}
+	intr_set_level(old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -397,18 +1086,52 @@ void cond_broadcast(struct condition *cond, struct lock *lock)
 
 /*
  * cmp_sem_priority()
- * semaphore_elem으로 부터 각 semaphore_elem의 쓰레드 디스크립터를 획득
- * 첫 번째 인자로 주어진 세마포어를 위해 대기 중인 가장 높은 우선순위의 스레드와 두 번째 인자로 주어진 세마포어를 위해 대기 중인 가장 높은 우선순위의 스레드와 비교
+ * semaphore_elem으로 부터 각 semaphore_elem의 대기 스레드를 얻어 우선순위를 비교
  */
-bool cmp_sem_priority(const struct list_elem *a, const struct list_elem *b, void *aux)
+bool cmp_sem_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
 {
 	struct semaphore_elem *sem_a = list_entry(a, struct semaphore_elem, elem);
 	struct semaphore_elem *sem_b = list_entry(b, struct semaphore_elem, elem);
 
-	struct thread *th_a = list_entry(list_begin(&(sem_a->semaphore.waiters)), struct thread, elem);
+	// 첫 번째 인자의 우선순위가 두 번째 인자의 우선순위보다 높으면 1을 반환, 낮으면 0을 반환
+	return sem_a->thread->priority > sem_b->thread->priority;
+}
 
-	struct thread *th_b = list_entry(list_begin(&(sem_b->semaphore.waiters)), struct thread, elem);
+/* sema_waiter_reposition()
+ * block된 스레드 T의 우선순위가 바뀌었을 때(priority donation),
+ * T가 대기 중인 semaphore와 condition variable의 waiters 안에서
+ * T의 위치를 옮겨 waiters를 우선순위 순으로 유지한다.
+ * 깨울 때 정렬할 필요가 없어진다. 인터럽트가 꺼진 상태에서 호출.
+ */
+void sema_waiter_reposition(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
 
-	// 첫 번째 인자의 우선순위가 두 번째 인자의 우선순위보다 높으면 1을 반환, 낮으면 0을 반환
-	return th_a->priority > th_b->priority ? true : false;
+	waiter_reorder(t);
+	/* lock을 기다리는 중이면 lock의 max_priority를 맨 앞 waiter로 다시 맞춘다.
+	 * 기부가 줄어든 경우에도 holder가 오래된 우선순위를 유지하지 않도록 한다. */
+	if (t->wait_on_lock != NULL && t->waiting_sema == &t->wait_on_lock->semaphore)
+		lock_refresh_max_priority(t->wait_on_lock);
+}
+
+/* Moves blocked thread T to its place among the waiters of the
+   semaphore and condition variable it waits on, and raises the
+   semaphore's owner if T now outranks it.  Unlike
+   sema_waiter_reposition(), it leaves the lock T waits for alone.
+   Interrupts must be off. */
+static void
+waiter_reorder(struct thread *t)
+{
+	if (t->waiting_sema != NULL)
+	{
+		list_remove(&t->elem);
+		list_insert_ordered(&t->waiting_sema->waiters, &t->elem, cmp_priority, NULL);
+		/* 올라간 우선순위를 semaphore owner에게도 전달 */
+		sema_donate(t->waiting_sema);
+	}
+	if (t->waiting_cond != NULL)
+	{
+		list_remove(t->cond_elem);
+		list_insert_ordered(&t->waiting_cond->waiters, t->cond_elem, cmp_sem_priority, NULL);
+	}
 }
\ No newline at end of file
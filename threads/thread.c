@@ -5,12 +5,16 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/rcu.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -36,35 +40,94 @@
 
 int load_avg;
 
+/* load_avg와 recent_cpu 갱신을 보호하는 seqlock.
+ * 값을 쓰는 쪽은 주로 timer 인터럽트이고, thread_get_load_avg()와
+ * thread_get_recent_cpu()는 인터럽트를 끄지 않고 읽은 뒤 필요하면 다시 읽는다. */
+static struct seqlock mlfqs_seq;
+
+/* recent_cpu는 lazy하게 감쇠한다.
+ * 1초(epoch)마다 timer 인터럽트는 그 epoch의 감쇠 계수
+ * (2*load_avg)/(2*load_avg + 1)만 decay_coef[]에 기록하고 mlfqs_epoch를 증가시킨다.
+ * 각 스레드는 recent_cpu_epoch에 마지막으로 감쇠된 epoch를 저장해 두고,
+ * run queue에 들어가거나 값이 필요할 때 놓친 epoch의 계수를 한꺼번에 적용한다.
+ * MLFQS_EPOCH_HISTORY 초보다 오래 block된 스레드는 가장 최근 계수들만 적용한다. */
+#define MLFQS_EPOCH_HISTORY 256
+static int mlfqs_epoch;
+static int decay_coef[MLFQS_EPOCH_HISTORY];
+
+/* 새 epoch가 시작되면 timer 인터럽트가 매 tick마다 run queue의 ready 스레드를
+ * 최대 MLFQS_REFRESH_BATCH개씩 현재 epoch까지 감쇠한다. (struct cpu의 refresh_pri 참고)
+ * 그 전에 스케줄된 스레드는 schedule()에서 한 개만 갱신하므로 스케줄러는 O(1)이다. */
+#define MLFQS_REFRESH_BATCH 8
+
 // 다음에 깨워야 할 ticks
 static int64_t next_tick_to_awake;
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-static struct list sleep_list;
+/* Per-CPU data, including each CPU's run queue of processes in
+   THREAD_READY state, that is, processes that are ready to run
+   but not actually running.  See threads/cpu.h.
+   Only the bootstrap processor is brought online, so cpu_cnt is
+   always 1 for now. */
+#if PRI_MAX >= 64
+#error ready_mask requires PRI_MAX < 64
+#endif
+struct cpu cpus[NCPU_MAX];
+int cpu_cnt;
+
+/* Sleeping threads, hashed by wakeup_tick into a timing wheel of
+   SLEEP_WHEEL_SIZE slots.  Each slot is kept sorted by
+   wakeup_tick, and bit N of sleep_wheel_mask is set iff
+   sleep_wheel[N] is nonempty, so waking threads only touches
+   nonempty slots and the expired threads at their fronts. */
+#define SLEEP_WHEEL_SIZE 64
+static struct list sleep_wheel[SLEEP_WHEEL_SIZE];
+static uint64_t sleep_wheel_mask;
 static struct list all_list;
 
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
-static struct lock tid_lock;
+/* tid -> thread index.  A thread is in the table from
+   thread_create() until thread_exit(); protected by disabling
+   interrupts. */
+#define TID_HASH_SIZE 64
+static struct list tid_hash[TID_HASH_SIZE];
 
 /* Thread destruction requests */
 static struct list destruction_req;
-
-/* Statistics. */
-static long long idle_ticks;   /* # of timer ticks spent idle. */
-static long long kernel_ticks; /* # of timer ticks in kernel threads. */
-static long long user_ticks;   /* # of timer ticks in user programs. */
+static size_t destruction_cnt; /* # of threads in destruction_req. */
+
+/* Reaper thread.  Frees the pages of dead threads in batches at
+   PRI_MIN, so that schedule() only has to queue them.  If the reaper
+   falls behind by more than REAP_BACKLOG_MAX threads (e.g. it is
+   starved by higher-priority threads), do_schedule() drains the
+   queue itself to bound the memory held by dead threads. */
+#define REAP_BACKLOG_MAX 32
+static struct thread *reaper_thread;
+
+/* True while the reaper is blocked waiting for work.  Only the
+   reaper's own wait loop sets it, and thread_wake_reaper() clears
+   it before unblocking, so a reaper that is blocked on anything
+   else (e.g. a lock taken while freeing) is never woken by
+   mistake.  Protected by disabling interrupts. */
+static bool reaper_idle;
+
+/* Caches of recycled thread pages and one-page fd tables.
+   A thread page needs no zeroing because init_thread() clears
+   struct thread and the stack is never read before written.
+   fd tables are cleared when they are put in the cache, which
+   normally happens in the reaper, off the thread_create() path.
+   Both lists link through a list_elem at the start of each page
+   and are protected by disabling interrupts. */
+#define THREAD_CACHE_MAX 16
+#define FDT_CACHE_MAX 16
+static struct list thread_page_cache;
+static size_t thread_page_cache_cnt;
+static struct list fdt_cache;
+static size_t fdt_cache_cnt;
 
 /* Scheduling. */
-#define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
+#define TIME_SLICE 4 /* # of timer ticks to give each thread. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
@@ -74,15 +137,30 @@ bool thread_mlfqs;
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
+static void reaper(void *aux UNUSED);
+static void reap_threads(struct list *);
+static struct thread *thread_page_alloc(void);
+static void thread_page_free(struct thread *);
+static struct file **fdt_alloc(void);
+static void fdt_free(struct file **, int cap);
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
+static void tid_hash_insert(struct thread *);
+static void cpu_init(struct cpu *, int id);
+static void ready_list_push(struct cpu *, struct thread *);
+static void ready_list_remove(struct cpu *, struct thread *);
+static struct thread *ready_list_pop(struct cpu *);
+static int ready_list_max_priority(struct cpu *);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
 
+/* Returns true if T is the idle thread of its CPU. */
+#define is_idle_thread(t) ((t)->cpu != NULL && (t) == (t)->cpu->idle_thread)
+
 /* Returns the running thread.
  * Read the CPU's stack pointer `rsp', and then round that
  * down to the start of a page.  Since `struct thread' is
@@ -121,17 +199,28 @@ void thread_init(void)
 	lgdt(&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init(&tid_lock);
-	list_init(&ready_list);
-	list_init(&sleep_list);
+	for (int i = 0; i < TID_HASH_SIZE; i++)
+		list_init(&tid_hash[i]);
+	seqlock_init(&mlfqs_seq);
+	cpu_init(&cpus[0], 0);
+	cpu_cnt = 1;
+	for (int slot = 0; slot < SLEEP_WHEEL_SIZE; slot++)
+		list_init(&sleep_wheel[slot]);
+	sleep_wheel_mask = 0;
+	next_tick_to_awake = INT64_MAX;
 	list_init(&destruction_req);
+	rcu_init();
+	list_init(&thread_page_cache);
+	list_init(&fdt_cache);
 	list_init(&all_list);
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread();
 	init_thread(initial_thread, "main", PRI_DEFAULT);
+	initial_thread->cpu = &cpus[0];
 	initial_thread->status = THREAD_RUNNING;
 	initial_thread->tid = allocate_tid();
+	tid_hash_insert(initial_thread);
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -142,6 +231,7 @@ void thread_start(void)
 	struct semaphore idle_started;
 	sema_init(&idle_started, 0);
 	thread_create("idle", PRI_MIN, idle, &idle_started);
+	thread_create("reaper", PRI_MIN, reaper, NULL);
 	load_avg = LOAD_AVG_DEFAULT;
 
 	/* Start preemptive thread scheduling. */
@@ -156,29 +246,48 @@ void thread_start(void)
 void thread_tick(void)
 {
 	struct thread *t = thread_current();
+	struct cpu *c = t->cpu;
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == c->idle_thread)
+		c->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
-		user_ticks++;
+		c->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
+		c->kernel_ticks++;
 
-	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	/* Enforce preemption.  intr_handler() defers the yield if
+	   we are inside an RCU read section. */
+	if (++c->thread_ticks >= TIME_SLICE)
 		intr_yield_on_return();
 }
 
 /* Prints thread statistics. */
 void thread_print_stats(void)
 {
+	long long idle_ticks = 0, kernel_ticks = 0, user_ticks = 0;
+
+	for (int i = 0; i < cpu_cnt; i++)
+	{
+		idle_ticks += cpus[i].idle_ticks;
+		kernel_ticks += cpus[i].kernel_ticks;
+		user_ticks += cpus[i].user_ticks;
+	}
 	printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 		   idle_ticks, kernel_ticks, user_ticks);
 }
 
+/* Returns the CPU that the running thread is executing on.
+   schedule() hands the CPU over to the next thread along with
+   the CPU pointer, so this is valid from any thread context. */
+struct cpu *
+this_cpu(void)
+{
+	return running_thread()->cpu;
+}
+
 /* Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -198,17 +307,26 @@ tid_t thread_create(const char *name, int priority,
 					thread_func *function, void *aux)
 {
 	struct thread *t;
+	struct file **fdt;
+	struct switch_threads_frame *sf;
 	tid_t tid;
 
 	ASSERT(function != NULL);
 
-	/* Allocate thread. */
-	t = palloc_get_page(PAL_ZERO);
+	/* Allocate thread and its fd table. */
+	t = thread_page_alloc();
 	if (t == NULL)
 		return TID_ERROR;
+	fdt = fdt_alloc();
+	if (fdt == NULL)
+	{
+		thread_page_free(t);
+		return TID_ERROR;
+	}
 
 	/* Initialize thread. */
 	init_thread(t, name, priority);
+	t->cpu = this_cpu();
 	tid = t->tid = allocate_tid();
 
 	/* project2 - user programs
@@ -216,11 +334,13 @@ tid_t thread_create(const char *name, int priority,
 	 */
 	struct thread *curr = thread_current();
 	list_push_back(&curr->child_list, &t->child_elem);
+	t->parent_tid = curr->tid;
+	tid_hash_insert(t);
 
-	/* 파일 디스크립터 초기화 */
-	t->fdTable = palloc_get_multiple(PAL_ZERO, FDT_PAGES);
-	if (t->fdTable == NULL)
-		return TID_ERROR;
+	/* 파일 디스크립터 초기화
+	 * 한 페이지짜리 테이블로 시작하고, 더 필요하면 thread_fdt_grow()로 확장 */
+	t->fdTable = fdt;
+	t->fdCap = FDT_SLOTS_PER_PAGE;
 
 	/* 추가로 fd table의 표준입력과 표준출력에 더미의 값을 넣는다.
 	 * 이는 read, write, close, dup2 시스템 콜을 사용할 때, 표준 입력, 표준 출력을 구분하기 위한 장치로 쓰인다.
@@ -236,15 +356,17 @@ tid_t thread_create(const char *name, int priority,
 	/* ---------------------project2--------------------*/
 
 	/* Call the kernel_thread if it scheduled.
-	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
-	t->tf.rip = (uintptr_t)kernel_thread;
-	t->tf.R.rdi = (uint64_t)function;
-	t->tf.R.rsi = (uint64_t)aux;
-	t->tf.ds = SEL_KDSEG;
-	t->tf.es = SEL_KDSEG;
-	t->tf.ss = SEL_KDSEG;
-	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
+	 * The first switch_threads() into T pops this frame and returns to
+	 * switch_entry, which calls kernel_thread(FUNCTION, AUX).  The frame
+	 * ends 16 bytes below the top of the page so that the stack is
+	 * 16-byte aligned at the call. */
+	sf = (struct switch_threads_frame *)((uint64_t)t + PGSIZE - 16) - 1;
+	sf->r12 = (uint64_t)function;
+	sf->r13 = (uint64_t)aux;
+	sf->r14 = (uint64_t)kernel_thread;
+	sf->rbp = 0;
+	sf->rip = switch_entry;
+	t->switch_rsp = (uint64_t)sf;
 
 	/* Add to run queue. */
 	thread_unblock(t);
@@ -287,8 +409,15 @@ void thread_unblock(struct thread *t)
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
 
+	/* block 되어 있는 동안 놓친 recent_cpu 감쇠를 반영 */
+	if (thread_mlfqs)
+	{
+		mlfqs_recent_cpu(t);
+		mlfqs_priority(t);
+	}
+
 	/* ready_list에 우선순위대로 삽입*/
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
+	ready_list_push(t->cpu, t);
 	t->status = THREAD_READY;
 	intr_set_level(old_level);
 }
@@ -342,6 +471,11 @@ void thread_exit(void)
 	 * exit된 경우 모든 list 삭제
 	 */
 	list_remove(&thread_current()->allelem);
+	list_remove(&thread_current()->tid_elem);
+	while (!list_empty(&thread_current()->owned_semas))
+		sema_set_owner(list_entry(list_front(&thread_current()->owned_semas),
+								  struct semaphore, owner_elem),
+					   NULL);
 
 	do_schedule(THREAD_DYING);
 	NOT_REACHED();
@@ -357,10 +491,10 @@ void thread_yield(void)
 	ASSERT(!intr_context());
 
 	old_level = intr_disable();
-	if (curr != idle_thread)
+	if (!is_idle_thread(curr))
 	{
 		// ready_list에 우선순위대로 삽입
-		list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
+		ready_list_push(curr->cpu, curr);
 	}
 
 	do_schedule(THREAD_READY);
@@ -438,10 +572,15 @@ int thread_get_load_avg(void)
 	// load_avg에 100을 곱해서 반환
 	// 해당 과정중에 인터럽트는 비활성되어야 한다.
 
-	enum intr_level old_level = intr_disable();
-	int load_avg_tmp = fp_to_int_round(mult_mixed(load_avg, 100));
-	intr_set_level(old_level);
-	return load_avg_tmp;
+	// 인터럽트를 끄는 대신 seqlock으로 일관된 값을 읽는다.
+	unsigned seq;
+	int load_avg_tmp;
+	do
+	{
+		seq = read_seqbegin(&mlfqs_seq);
+		load_avg_tmp = load_avg;
+	} while (read_seqretry(&mlfqs_seq, seq));
+	return fp_to_int_round(mult_mixed(load_avg_tmp, 100));
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
@@ -450,11 +589,16 @@ int thread_get_recent_cpu(void)
 	/* TODO: Your implementation goes here */
 	// recent_cpu에 100을 곱해서 반환
 	// 해당 과정중에 인터럽트는 비활성되어야 한다.
-	enum intr_level old_level = intr_disable();
-	int curr_recent_cpu = thread_current()->recent_cpu;
-	curr_recent_cpu = fp_to_int_round(mult_mixed(curr_recent_cpu, 100));
-	intr_set_level(old_level);
-	return curr_recent_cpu;
+	// 인터럽트를 끄는 대신 seqlock으로 일관된 값을 읽는다.
+	struct thread *t = thread_current();
+	unsigned seq;
+	int curr_recent_cpu;
+	do
+	{
+		seq = read_seqbegin(&mlfqs_seq);
+		curr_recent_cpu = t->recent_cpu;
+	} while (read_seqretry(&mlfqs_seq, seq));
+	return fp_to_int_round(mult_mixed(curr_recent_cpu, 100));
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -471,7 +615,7 @@ idle(void *idle_started_ UNUSED)
 {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current();
+	this_cpu()->idle_thread = thread_current();
 	sema_up(idle_started);
 
 	for (;;)
@@ -480,6 +624,10 @@ idle(void *idle_started_ UNUSED)
 		intr_disable();
 		thread_block();
 
+		/* Nothing else to run.  In tickless mode, stop the
+		   periodic tick until the next sleeper is due. */
+		timer_idle_enter();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -499,6 +647,173 @@ idle(void *idle_started_ UNUSED)
 	}
 }
 
+/* Reaper thread.  Sleeps until schedule() queues a dead thread,
+   then frees everything queued so far with interrupts enabled. */
+static void
+reaper(void *aux UNUSED)
+{
+	struct list dead;
+
+	reaper_thread = thread_current();
+	/* Under mlfqs PRI_MIN is meaningless; stay as nice as possible. */
+	if (thread_mlfqs)
+		thread_set_nice(NICE_MAX);
+
+	list_init(&dead);
+	for (;;)
+	{
+		enum intr_level old_level = intr_disable();
+		while (list_empty(&destruction_req) && !rcu_callbacks_pending())
+		{
+			reaper_idle = true;
+			thread_block();
+		}
+
+		/* Take the whole batch at once. */
+		while (!list_empty(&destruction_req))
+			list_push_back(&dead, list_pop_front(&destruction_req));
+		destruction_cnt = 0;
+		intr_set_level(old_level);
+
+		reap_threads(&dead);
+		rcu_process_callbacks();
+	}
+}
+
+/* Wakes the reaper if it is waiting for work.  If it is busy, or
+   blocked somewhere other than its wait loop, it will see the new
+   work the next time it checks. */
+void thread_wake_reaper(void)
+{
+	enum intr_level old_level = intr_disable();
+	if (reaper_idle)
+	{
+		reaper_idle = false;
+		thread_unblock(reaper_thread);
+	}
+	intr_set_level(old_level);
+}
+
+/* Frees the fd tables and pages of the dead threads in LIST,
+   leaving LIST empty. */
+static void
+reap_threads(struct list *list)
+{
+	while (!list_empty(list))
+	{
+		struct thread *victim =
+			list_entry(list_pop_front(list), struct thread, elem);
+		if (victim->fdTable != NULL)
+			fdt_free(victim->fdTable, victim->fdCap);
+		thread_page_free(victim);
+	}
+}
+
+/* Returns a page for a new thread, from the cache if possible.
+   The page is not zeroed. */
+static struct thread *
+thread_page_alloc(void)
+{
+	struct thread *t = NULL;
+	enum intr_level old_level = intr_disable();
+
+	if (!list_empty(&thread_page_cache))
+	{
+		t = (struct thread *)list_pop_front(&thread_page_cache);
+		thread_page_cache_cnt--;
+	}
+	intr_set_level(old_level);
+
+	return t != NULL ? t : palloc_get_page(0);
+}
+
+/* Returns thread page T to the cache, or to the page allocator if
+   the cache is full. */
+static void
+thread_page_free(struct thread *t)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (thread_page_cache_cnt < THREAD_CACHE_MAX)
+	{
+		list_push_front(&thread_page_cache, (struct list_elem *)t);
+		thread_page_cache_cnt++;
+		t = NULL;
+	}
+	intr_set_level(old_level);
+
+	if (t != NULL)
+		palloc_free_page(t);
+}
+
+/* Returns a zeroed one-page fd table, from the cache if possible. */
+static struct file **
+fdt_alloc(void)
+{
+	struct file **fdt = NULL;
+	enum intr_level old_level = intr_disable();
+
+	if (!list_empty(&fdt_cache))
+	{
+		fdt = (struct file **)list_pop_front(&fdt_cache);
+		fdt_cache_cnt--;
+	}
+	intr_set_level(old_level);
+
+	if (fdt == NULL)
+		return palloc_get_page(PAL_ZERO);
+
+	/* Only the list_elem is dirty; the rest was cleared in fdt_free(). */
+	memset(fdt, 0, sizeof(struct list_elem));
+	return fdt;
+}
+
+/* Frees fd table FDT of CAP entries.  One-page tables are cleared
+   and cached for fdt_alloc(). */
+static void
+fdt_free(struct file **fdt, int cap)
+{
+	if (cap == FDT_SLOTS_PER_PAGE && fdt_cache_cnt < FDT_CACHE_MAX)
+	{
+		enum intr_level old_level;
+
+		memset(fdt, 0, PGSIZE);
+		old_level = intr_disable();
+		if (fdt_cache_cnt < FDT_CACHE_MAX)
+		{
+			list_push_front(&fdt_cache, (struct list_elem *)fdt);
+			fdt_cache_cnt++;
+			fdt = NULL;
+		}
+		intr_set_level(old_level);
+	}
+
+	if (fdt != NULL)
+		palloc_free_multiple(fdt, cap / FDT_SLOTS_PER_PAGE);
+}
+
+/* Makes sure that T's fd table has an entry for FD, growing it to
+   its full FDCOUNT_LIMIT size if necessary.  Returns false if FD is
+   out of range or memory is exhausted. */
+bool thread_fdt_grow(struct thread *t, int fd)
+{
+	struct file **fdt;
+
+	if (fd < t->fdCap)
+		return true;
+	if (fd >= FDCOUNT_LIMIT)
+		return false;
+
+	fdt = palloc_get_multiple(PAL_ZERO, FDT_PAGES);
+	if (fdt == NULL)
+		return false;
+	memcpy(fdt, t->fdTable, t->fdCap * sizeof *fdt);
+	fdt_free(t->fdTable, t->fdCap);
+	t->fdTable = fdt;
+	t->fdCap = FDCOUNT_LIMIT;
+	return true;
+}
+
 /* Function used as the basis for a kernel thread. */
 static void
 kernel_thread(thread_func *function, void *aux)
@@ -522,19 +837,20 @@ init_thread(struct thread *t, const char *name, int priority)
 	memset(t, 0, sizeof *t);
 	t->status = THREAD_BLOCKED;
 	strlcpy(t->name, name, sizeof t->name);
-	t->tf.rsp = (uint64_t)t + PGSIZE - sizeof(void *);
 	t->priority = priority;
 	t->magic = THREAD_MAGIC;
 
 	/* project - Priority Donation init */
 	t->init_priority = priority;
-	list_init(&t->donations);
+	list_init(&t->held_locks);
+	list_init(&t->owned_semas);
 
 	/* project - advanced scheduler */
 	if (thread_mlfqs)
 	{
 		t->nice = NICE_DEFAULT;
 		t->recent_cpu = RECENT_CPU_DEFAULT;
+		t->recent_cpu_epoch = mlfqs_epoch;
 	}
 	/* 자식 리스트 및 세마포어 초기화 */
 	/* project - user programs */
@@ -543,6 +859,9 @@ init_thread(struct thread *t, const char *name, int priority)
 	sema_init(&t->wait_sema, 0);
 	sema_init(&t->fork_sema, 0);
 	sema_init(&t->free_sema, 0);
+	/* wait_sema와 fork_sema는 자식 자신이 up 하므로, 기다리는 부모가 자식에게 기부한다 */
+	sema_set_owner(&t->wait_sema, t);
+	sema_set_owner(&t->fork_sema, t);
 
 	t->running = NULL;
 }
@@ -555,10 +874,110 @@ init_thread(struct thread *t, const char *name, int priority)
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
-		return idle_thread;
+	struct cpu *c = this_cpu();
+	struct thread *next;
+
+	spin_lock(&c->rq_lock);
+	next = c->ready_mask == 0 ? c->idle_thread : ready_list_pop(c);
+	spin_unlock(&c->rq_lock);
+	return next;
+}
+
+/* Initializes per-CPU data C of CPU number ID, with an empty run
+   queue. */
+static void
+cpu_init(struct cpu *c, int id)
+{
+	memset(c, 0, sizeof *c);
+	c->id = id;
+	c->refresh_pri = -1;
+	spin_lock_init(&c->rq_lock);
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init(&c->ready_list[pri]);
+}
+
+/* Appends T to the run queue of its priority level on CPU C. */
+static void
+ready_list_push(struct cpu *c, struct thread *t)
+{
+	ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	spin_lock(&c->rq_lock);
+	t->cpu = c;
+	list_push_back(&c->ready_list[t->priority], &t->elem);
+	c->ready_mask |= 1ULL << t->priority;
+	c->ready_cnt++;
+	spin_unlock(&c->rq_lock);
+}
+
+/* Removes T, which must be in the run queue of its current
+   priority level on CPU C, from the run queue. */
+static void
+ready_list_remove(struct cpu *c, struct thread *t)
+{
+	ASSERT(t->status == THREAD_READY);
+
+	spin_lock(&c->rq_lock);
+	list_remove(&t->elem);
+	if (list_empty(&c->ready_list[t->priority]))
+		c->ready_mask &= ~(1ULL << t->priority);
+	c->ready_cnt--;
+	spin_unlock(&c->rq_lock);
+}
+
+/* Removes and returns the oldest thread of the highest nonempty
+   priority level on CPU C.  The run queue must not be empty, and
+   C's rq_lock must be held. */
+static struct thread *
+ready_list_pop(struct cpu *c)
+{
+	int pri = ready_list_max_priority(c);
+	struct thread *t;
+
+	ASSERT(pri >= PRI_MIN);
+	t = list_entry(list_pop_front(&c->ready_list[pri]), struct thread, elem);
+	if (list_empty(&c->ready_list[pri]))
+		c->ready_mask &= ~(1ULL << pri);
+	c->ready_cnt--;
+	return t;
+}
+
+/* Returns the highest priority among ready threads on CPU C, or
+   -1 if its run queue is empty. */
+static int
+ready_list_max_priority(struct cpu *c)
+{
+	uint64_t mask = c->ready_mask;
+
+	if (mask == 0)
+		return -1;
+	return 63 - __builtin_clzll(mask);
+}
+
+/* T의 우선순위를 PRIORITY로 변경.
+ * T가 ready 상태라면 새 우선순위의 run queue로 옮긴다. */
+void thread_set_effective_priority(struct thread *t, int priority)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (t->status == THREAD_READY && t->priority != priority)
+	{
+		struct cpu *c = t->cpu;
+
+		ready_list_remove(c, t);
+		t->priority = priority;
+		ready_list_push(c, t);
+	}
+	else if (t->status == THREAD_BLOCKED && t->priority != priority)
+	{
+		/* 대기 중인 waiters 안에서도 제자리로 옮긴다 */
+		t->priority = priority;
+		sema_waiter_reposition(t);
+	}
 	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+		t->priority = priority;
+
+	intr_set_level(old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -604,62 +1023,16 @@ void do_iret(struct intr_frame *tf)
 static void
 thread_launch(struct thread *th)
 {
-	uint64_t tf_cur = (uint64_t)&running_thread()->tf;
-	uint64_t tf = (uint64_t)&th->tf;
 	ASSERT(intr_get_level() == INTR_OFF);
 
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile(
-		/* Store registers that will be used. */
-		"push %%rax\n"
-		"push %%rbx\n"
-		"push %%rcx\n"
-		/* Fetch input once */
-		"movq %0, %%rax\n"
-		"movq %1, %%rcx\n"
-		"movq %%r15, 0(%%rax)\n"
-		"movq %%r14, 8(%%rax)\n"
-		"movq %%r13, 16(%%rax)\n"
-		"movq %%r12, 24(%%rax)\n"
-		"movq %%r11, 32(%%rax)\n"
-		"movq %%r10, 40(%%rax)\n"
-		"movq %%r9, 48(%%rax)\n"
-		"movq %%r8, 56(%%rax)\n"
-		"movq %%rsi, 64(%%rax)\n"
-		"movq %%rdi, 72(%%rax)\n"
-		"movq %%rbp, 80(%%rax)\n"
-		"movq %%rdx, 88(%%rax)\n"
-		"pop %%rbx\n" // Saved rcx
-		"movq %%rbx, 96(%%rax)\n"
-		"pop %%rbx\n" // Saved rbx
-		"movq %%rbx, 104(%%rax)\n"
-		"pop %%rbx\n" // Saved rax
-		"movq %%rbx, 112(%%rax)\n"
-		"addq $120, %%rax\n"
-		"movw %%es, (%%rax)\n"
-		"movw %%ds, 8(%%rax)\n"
-		"addq $32, %%rax\n"
-		"call __next\n" // read the current rip.
-		"__next:\n"
-		"pop %%rbx\n"
-		"addq $(out_iret -  __next), %%rbx\n"
-		"movq %%rbx, 0(%%rax)\n" // rip
-		"movw %%cs, 8(%%rax)\n"	 // cs
-		"pushfq\n"
-		"popq %%rbx\n"
-		"mov %%rbx, 16(%%rax)\n" // eflags
-		"mov %%rsp, 24(%%rax)\n" // rsp
-		"movw %%ss, 32(%%rax)\n"
-		"mov %%rcx, %%rdi\n"
-		"call do_iret\n"
-		"out_iret:\n"
-		:
-		: "g"(tf_cur), "g"(tf)
-		: "memory");
+	/* Kernel-to-kernel switch.
+	 * Every thread enters here from schedule() with interrupts off and
+	 * in kernel mode, so only the callee-saved registers and rsp need to
+	 * be preserved; segment registers and rflags are identical on both
+	 * sides.  A full intr_frame + iretq is only needed for the first
+	 * entry into user mode, which process_exec() and __do_fork() do
+	 * themselves through do_iret(). */
+	switch_threads(&running_thread()->switch_rsp, th->switch_rsp);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -671,11 +1044,12 @@ do_schedule(int status)
 {
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(thread_current()->status == THREAD_RUNNING);
-	while (!list_empty(&destruction_req))
+	/* Normally the reaper frees dead threads.  Only reap here when it
+	   has fallen too far behind (or does not exist yet). */
+	if (destruction_cnt > REAP_BACKLOG_MAX)
 	{
-		struct thread *victim =
-			list_entry(list_pop_front(&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		destruction_cnt = 0;
+		reap_threads(&destruction_req);
 	}
 	thread_current()->status = status;
 	schedule();
@@ -690,11 +1064,22 @@ schedule(void)
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(curr->status != THREAD_RUNNING);
 	ASSERT(is_thread(next));
-	/* Mark us as running. */
+	ASSERT(curr->rcu_nesting == 0);
+	/* Mark us as running, and hand this CPU over to NEXT. */
 	next->status = THREAD_RUNNING;
+	next->cpu = curr->cpu;
+
+	/* run queue 갱신이 아직 NEXT에 닿지 않았다면 NEXT 하나만 갱신 */
+	if (thread_mlfqs && next->recent_cpu_epoch != mlfqs_epoch)
+	{
+		mlfqs_recent_cpu(next);
+		mlfqs_priority(next);
+	}
 
-	/* Start new time slice. */
-	thread_ticks = 0;
+	/* Start new time slice.  Switching threads is also an RCU
+	   quiescent state for this CPU. */
+	curr->cpu->thread_ticks = 0;
+	curr->cpu->rcu_qs++;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -708,12 +1093,13 @@ schedule(void)
 		   pull out the rug under itself.
 		   We just queuing the page free reqeust here because the page is
 		   currently used bye the stack.
-		   The real destruction logic will be called at the beginning of the
-		   schedule(). */
+		   The reaper thread does the real destruction later. */
 		if (curr && curr->status == THREAD_DYING && curr != initial_thread)
 		{
 			ASSERT(curr != next);
 			list_push_back(&destruction_req, &curr->elem);
+			destruction_cnt++;
+			thread_wake_reaper();
 		}
 
 		/* Before switching the thread, we first save the information
@@ -727,13 +1113,42 @@ static tid_t
 allocate_tid(void)
 {
 	static tid_t next_tid = 1;
-	tid_t tid;
 
-	lock_acquire(&tid_lock);
-	tid = next_tid++;
-	lock_release(&tid_lock);
+	/* A single atomic increment; never blocks, so it is safe with
+	   interrupts off and on any CPU. */
+	return __atomic_fetch_add(&next_tid, 1, __ATOMIC_RELAXED);
+}
 
-	return tid;
+/* Adds T to the tid index. */
+static void
+tid_hash_insert(struct thread *t)
+{
+	enum intr_level old_level = intr_disable();
+	list_push_front(&tid_hash[(unsigned)t->tid % TID_HASH_SIZE], &t->tid_elem);
+	intr_set_level(old_level);
+}
+
+/* Returns the live thread whose tid is TID, or NULL if there is
+   none. */
+struct thread *
+thread_by_tid(tid_t tid)
+{
+	struct list *bucket = &tid_hash[(unsigned)tid % TID_HASH_SIZE];
+	struct thread *found = NULL;
+	struct list_elem *e;
+	enum intr_level old_level = intr_disable();
+
+	for (e = list_begin(bucket); e != list_end(bucket); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, tid_elem);
+		if (t->tid == tid)
+		{
+			found = t;
+			break;
+		}
+	}
+	intr_set_level(old_level);
+	return found;
 }
 
 /* 스레드를 block상태로 만들고 sleep queue에 삽입 */
@@ -743,41 +1158,63 @@ void thread_sleep(int64_t ticks)
 	struct thread *t = thread_current();
 	ASSERT(!intr_context()); // 외부 인터럽트 없을 때 실행
 
-	if (t != idle_thread)
+	if (!is_idle_thread(t))
 	{
+		/* wakeup_tick이 음수일 수도 있으므로 unsigned로 slot 계산 */
+		size_t slot = (uint64_t)ticks % SLEEP_WHEEL_SIZE;
+
 		t->wakeup_tick = ticks; // 일어날 시간 설정
 		update_next_tick_to_awake(ticks);
-		list_push_back(&sleep_list, &(t->elem)); // sleep_list 맨 뒤에 삽입
-		thread_block();							 // 실행중인 스레드 block
+		// slot 안에서는 wakeup_tick 순서대로 삽입
+		list_insert_ordered(&sleep_wheel[slot], &t->elem, cmp_wakeup_tick, NULL);
+		sleep_wheel_mask |= 1ULL << slot;
+		thread_block(); // 실행중인 스레드 block
 	}
 
 	intr_set_level(old_level); // 인터럽트 복구
 }
 
-/* sleep queue에서 깨워야 할 스레드를 찾아서 wake up */
+/* sleep queue에서 깨워야 할 스레드를 찾아서 wake up
+ * 비어있지 않은 slot의 앞쪽에서 시간이 지난 스레드만 꺼내고,
+ * 남은 slot들의 맨 앞 원소 중 최소값을 next_tick_to_awake로 저장 */
 void thread_awake(int64_t ticks)
 {
+	uint64_t mask = sleep_wheel_mask;
+
+	if (ticks < next_tick_to_awake)
+		return;
+
 	next_tick_to_awake = INT64_MAX;
-	struct thread *t;
-	struct list_elem *tmp = list_begin(&sleep_list); // sleep list의 첫번째 원소
-	for (tmp; tmp != list_end(&sleep_list); tmp = list_next(tmp))
+	while (mask != 0)
 	{
-		t = list_entry(tmp, struct thread, elem);
-		if (t->wakeup_tick <= ticks)
+		int slot = __builtin_ctzll(mask);
+		struct list *bucket = &sleep_wheel[slot];
+		mask &= mask - 1;
+
+		while (!list_empty(bucket))
 		{
-			// sleep_list에서 제거
-			tmp = list_prev(list_remove(tmp));
-			// block시키고 ready_list에 추가
+			struct thread *t = list_entry(list_front(bucket), struct thread, elem);
+			if (t->wakeup_tick > ticks)
+			{
+				update_next_tick_to_awake(t->wakeup_tick);
+				break;
+			}
+			// sleep_wheel에서 제거하고 ready_list에 추가
+			list_pop_front(bucket);
 			thread_unblock(t);
 		}
-		else
-		{
-			update_next_tick_to_awake(t->wakeup_tick);
-		}
+		if (list_empty(bucket))
+			sleep_wheel_mask &= ~(1ULL << slot);
 	}
-	// wakeup_tick값(스레드가 일어날 시간)이 인자로 들어온 ticks값()
-	// 현재 대기중인 스레드들의 wakeup_tick 변수 중 가장 작은 값을
-	// next_tick_to_awake 전역변수에 저장
+}
+
+/* 인자로 주어진 스레드들의 wakeup_tick을 비교 */
+bool cmp_wakeup_tick(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	struct thread *a_thread = list_entry(a, struct thread, elem);
+	struct thread *b_thread = list_entry(b, struct thread, elem);
+
+	return a_thread->wakeup_tick < b_thread->wakeup_tick;
 }
 
 /* 스레드들이 가진 tick값에서 최소값을 저장 - 가장 빨리 일어날 스레드 */
@@ -795,13 +1232,20 @@ int64_t get_next_tick_to_awake(void)
 /* 현재 수행중인 스레드와 가장높은 순위의 스레드를 비교해서 스케줄링 → 선점 판단 */
 void test_max_priority(void)
 {
+	struct cpu *c = this_cpu();
 
-	int curr_pri = thread_get_priority();
-	struct thread *ready_thread = list_entry(list_begin(&ready_list), struct thread, elem);
+	if (c->ready_mask == 0)
+		return;
 
-	if (curr_pri < ready_thread->priority)
+	if (thread_get_priority() < ready_list_max_priority(c))
 	{
-		thread_yield();
+		/* 인터럽트 핸들러에서 sema_up 한 경우 핸들러가 끝날 때 양보 */
+		if (intr_context())
+			intr_yield_on_return();
+		else if (thread_current()->rcu_nesting > 0)
+			thread_current()->rcu_yield_deferred = true;
+		else
+			thread_yield();
 	}
 }
 
@@ -814,39 +1258,56 @@ bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *au
 	return a_thread->priority > b_thread->priority ? 1 : 0;
 }
 
+/* cmp_lock_priority : held_locks를 lock의 max_priority 내림차순으로 유지 */
+bool cmp_lock_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	return list_entry(a, struct lock, elem)->max_priority > list_entry(b, struct lock, elem)->max_priority;
+}
+
 /* priority donation을 수행 */
 void donate_priority(void)
 {
 	/*
 	 * project 3 - Priority Donation
-	 * 현재 스레드가 기다리고 있는 lock 과 연결 된 모든 스레드들을 순회하며
-	 * 현재 스레드의 우선순위를 lock 을 보유하고 있는 스레드에게 기부 한다.
+	 * 현재 스레드가 기다리고 있는 lock 과 연결 된 스레드들을 따라가며
+	 * 현재 스레드의 우선순위를 lock 의 max_priority와 holder에게 기부 한다.
+	 * 이미 충분히 높은 holder를 만나면 그 뒤는 갱신할 필요가 없으므로 멈춘다.
 	 * (Nested donation 그림 참고, nested depth 는 8로 제한한다. )
 	 */
 	struct thread *t = thread_current();
-	struct lock *cur_lock = t->wait_on_lock;
+	enum intr_level old_level = intr_disable();
 
-	for (; cur_lock != NULL; cur_lock = cur_lock->holder->wait_on_lock)
-	{
-		cur_lock->holder->priority = t->priority;
-	}
+	donate_priority_chain(t->wait_on_lock, t->priority, 0);
+	intr_set_level(old_level);
 }
 
-/* donation list에서 스레드 엔트리를 제거 */
-void remove_with_lock(struct lock *lock)
+/* Donates PRIORITY to the holder of LOCK, then to the holder of
+   the lock that holder waits for, and so on, stopping at a holder
+   that already has PRIORITY.  DEPTH locks of the chain have been
+   followed already; at most DONATION_DEPTH_MAX are followed in
+   all.  Interrupts must be off. */
+void donate_priority_chain(struct lock *lock, int priority, int depth)
 {
-	/* lock 을 해지 했을때 donations 리스트에서 해당 엔트리를
-		삭제 하기 위한 함수를 구현한다. */
-	/* 현재 스레드의 donations 리스트를 확인하여 해지 할 lock 을
-		보유하고 있는 엔트리를 삭제 한다. */
-	struct list_elem *del_elem = list_begin(&lock->holder->donations);
-	for (; del_elem != list_end(&lock->holder->donations); del_elem = list_next(del_elem))
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (; lock != NULL && depth < DONATION_DEPTH_MAX; depth++)
 	{
-		struct thread *del_thread = list_entry(del_elem, struct thread, d_elem);
-		if (del_thread->wait_on_lock == lock)
+		struct thread *holder = lock->holder;
+		if (holder == NULL)
+			break;
+
+		/* holder의 held_locks 안에서 이 lock의 위치를 갱신 */
+		if (lock->max_priority < priority)
 		{
-			list_remove(del_elem);
+			lock->max_priority = priority;
+			list_remove(&lock->elem);
+			list_insert_ordered(&holder->held_locks, &lock->elem, cmp_lock_priority, NULL);
 		}
+
+		if (holder->priority >= priority)
+			break;
+		thread_set_effective_priority(holder, priority);
+		lock = holder->wait_on_lock;
 	}
 }
 
@@ -856,23 +1317,36 @@ void refresh_priority(void)
 	/* 스레드의 우선순위가 변경 되었을때 donation 을 고려하여
 	우선순위를 다시 결정 하는 함수를 작성
 	* 현재 스레드의 우선순위를 기부받기 전의 우선순위로 변경
-	* 가장 우선순위가 높은 donations 리스트의 스레드와
-	* 현재 스레드의 우선순위를 비교하여 높은 값을 현재 스레드의
-	우선순위로 설정한다.
+	* held_locks는 max_priority 순으로 정렬되어 있으므로 맨 앞 lock의
+	* max_priority와 비교하여 높은 값을 현재 스레드의 우선순위로 설정한다.
 	*/
 
 	struct thread *t = thread_current();
-	t->priority = t->init_priority;
+	t->priority = thread_donated_priority(t);
+}
+
+/* thread_donated_priority() - T가 받은 기부를 모두 반영한 우선순위를 계산 */
+int thread_donated_priority(struct thread *t)
+{
+	int priority = t->init_priority;
 
-	struct list_elem *tmp_delem = list_begin(&t->donations);
-	for (; tmp_delem != list_end(&t->donations); tmp_delem = list_next(tmp_delem))
+	if (!list_empty(&t->held_locks))
 	{
-		struct thread *tmp_thread = list_entry(tmp_delem, struct thread, d_elem);
-		if (tmp_thread->priority > t->priority)
-		{
-			t->priority = tmp_thread->priority;
-		}
+		struct lock *top = list_entry(list_front(&t->held_locks), struct lock, elem);
+		if (top->max_priority > priority)
+			priority = top->max_priority;
 	}
+
+	/* 보유 중인 rwlock에서 대기 중인 스레드의 기부도 반영 */
+	int rw_priority = rw_donated_priority(t);
+	if (rw_priority > priority)
+		priority = rw_priority;
+
+	/* owner로 등록된 semaphore에서 대기 중인 스레드의 기부도 반영 */
+	int sema_priority = sema_donated_priority(t);
+	if (sema_priority > priority)
+		priority = sema_priority;
+	return priority;
 }
 
 /* mlfqs_priority : recent_cpu와 nice값을 이용하여 priority를 계산
@@ -881,7 +1355,7 @@ void refresh_priority(void)
 void mlfqs_priority(struct thread *t)
 {
 	// 해당 스레드가 idel_thread가 아닌지 검사
-	if (t == idle_thread)
+	if (is_idle_thread(t))
 	{
 		return;
 	}
@@ -889,30 +1363,39 @@ void mlfqs_priority(struct thread *t)
 	{
 		int pre = PRI_MAX - t->nice * 2;		 // 정수
 		int post = div_mixed(t->recent_cpu, -4); // 실수
-		t->priority = fp_to_int(add_mixed(post, pre));
+		int priority = fp_to_int(add_mixed(post, pre));
+
+		/* PRI_MIN ~ PRI_MAX 범위로 제한 (run queue 인덱스로 사용) */
+		if (priority < PRI_MIN)
+			priority = PRI_MIN;
+		else if (priority > PRI_MAX)
+			priority = PRI_MAX;
+		thread_set_effective_priority(t, priority);
 		// thread_get_nice
 		// priority 계산식을 구현 (fixed_point.h의 계산함수 이용))
 	}
 }
 
-/* mlfqs_recent_cpu : recent_cpu 값 계산
+/* mlfqs_recent_cpu : T의 recent_cpu를 현재 epoch까지 감쇠
  * recent_cpu = (load_avg * 2) / (load_avg * 2 + 1) * recent_cpu + nice
+ * 계수는 epoch마다 decay_coef[]에 미리 계산되어 있으므로,
+ * 놓친 epoch 수만큼 곱셈/덧셈만 수행한다.
  */
 void mlfqs_recent_cpu(struct thread *t)
 {
+	int missed = mlfqs_epoch - t->recent_cpu_epoch;
+
+	t->recent_cpu_epoch = mlfqs_epoch;
 	// 해당 스레드가 idel_thread라면 리턴
-	if (t == idle_thread)
-	{
+	if (is_idle_thread(t) || missed <= 0)
 		return;
-	}
-	else
-	{
-		// recent_cpu 계산식을 구현
-		int pre = mult_mixed(load_avg, 2); // 실수
-		int in = add_mixed(pre, 1);		   // 실수
-		// t->recent_cpu = add_mixed(div_fp(pre, in), t->nice); // 실수
-		t->recent_cpu = add_mixed(mult_fp(div_fp(pre, in), t->recent_cpu), t->nice);
-	}
+
+	if (missed > MLFQS_EPOCH_HISTORY)
+		missed = MLFQS_EPOCH_HISTORY;
+	write_seqlock(&mlfqs_seq);
+	for (int e = mlfqs_epoch - missed + 1; e <= mlfqs_epoch; e++)
+		t->recent_cpu = add_mixed(mult_fp(decay_coef[e % MLFQS_EPOCH_HISTORY], t->recent_cpu), t->nice);
+	write_sequnlock(&mlfqs_seq);
 }
 
 /* mlfqs_load_avg : load_avg 값 계산
@@ -923,19 +1406,19 @@ void mlfqs_load_avg(void)
 {
 	// load_avg 계산식을 구현
 
-	int ready_threads;
-	if (thread_current() == idle_thread)
-	{
-		ready_threads = list_size(&ready_list);
-	}
-	else
+	int ready_threads = 0;
+	for (int i = 0; i < cpu_cnt; i++)
+		ready_threads += cpus[i].ready_cnt;
+	if (!is_idle_thread(thread_current()))
 	{
-		ready_threads = list_size(&ready_list) + 1; // list_size + running_thread
+		ready_threads += 1; // ready_cnt + running_thread
 	}
 	int pre = mult_fp(div_mixed(int_to_fp(59), 60), load_avg);
 	int post = mult_mixed(div_mixed(int_to_fp(1), 60), ready_threads);
 
+	write_seqlock(&mlfqs_seq);
 	load_avg = add_fp(pre, post);
+	write_sequnlock(&mlfqs_seq);
 	return;
 }
 
@@ -944,61 +1427,88 @@ void mlfqs_load_avg(void)
 void mlfqs_increment(void)
 {
 	// 해당 스레드가 idel_thread가 아닌지 검사
-	if (thread_current() == idle_thread)
+	if (is_idle_thread(thread_current()))
 	{
 		return;
 	}
 	else
 	{
 		// 현재 스레드의 recent_cpu 값을 1 증가
+		write_seqlock(&mlfqs_seq);
 		thread_current()->recent_cpu = add_mixed(thread_current()->recent_cpu, 1);
+		write_sequnlock(&mlfqs_seq);
 	}
 }
 
-/* mlfqs_recalc : 모든 thread의 recent_cpu와 priority값 재계산
+/* mlfqs_recalc_priority : 4tick 마다 priority 재계산
+ * recent_cpu가 매 tick 바뀌는 것은 running thread 뿐이므로 현재 스레드만 계산한다.
+ * ready 스레드는 epoch가 바뀐 뒤 mlfqs_refresh_ready()에서,
+ * block된 스레드는 thread_unblock()에서 갱신된다.
  */
 void mlfqs_recalc_priority(void)
 {
-	// ready list, sleep list, current 모든 thread 재계산
-	struct list_elem *e;
-	struct thread *t;
-	for (e = list_begin(&ready_list); e != list_end(&ready_list); e = list_next(e))
-	{
-		t = list_entry(e, struct thread, elem);
-		mlfqs_priority(t);
-	}
+	mlfqs_priority(thread_current());
+}
 
-	for (e = list_begin(&sleep_list); e != list_end(&sleep_list); e = list_next(e))
-	{
-		t = list_entry(e, struct thread, elem);
-		mlfqs_priority(t);
-	}
+/* mlfqs_recalc_recent_cpu : 1초마다 새 epoch 시작
+ * 이번 epoch의 감쇠 계수만 계산해 두고 실제 감쇠는 각 스레드에서 lazy하게 적용한다.
+ * 스레드 수와 관계 없이 O(1).
+ */
+void mlfqs_recalc_recent_cpu(void)
+{
+	int twice_load = mult_mixed(load_avg, 2);
 
-	// running thread의 값 갱신
-	mlfqs_priority(thread_current());
+	mlfqs_epoch++;
+	decay_coef[mlfqs_epoch % MLFQS_EPOCH_HISTORY] = div_fp(twice_load, add_mixed(twice_load, 1));
+	for (int i = 0; i < cpu_cnt; i++)
+		cpus[i].refresh_pri = PRI_MAX;
 
-	return;
+	// running thread는 바로 갱신
+	mlfqs_recent_cpu(thread_current());
 }
 
-void mlfqs_recalc_recent_cpu(void)
+/* mlfqs_refresh_ready : 매 tick마다 현재 CPU의 run queue에서
+ * 아직 감쇠되지 않은 ready 스레드를 최대 MLFQS_REFRESH_BATCH개 갱신한다.
+ * 높은 우선순위부터 각 level의 맨 앞 스레드를 갱신해 맨 뒤로 보낸다.
+ * 스레드는 항상 뒤에 붙으므로 맨 앞이 이미 갱신된 스레드면 그 level은 끝난 것이다.
+ * 인터럽트가 꺼진 상태에서 timer 인터럽트가 호출한다.
+ */
+void mlfqs_refresh_ready(void)
 {
-	// ready list, sleep list, current 모든 thread 재계산
-	struct list_elem *e;
-	struct thread *t;
-	for (e = list_begin(&ready_list); e != list_end(&ready_list); e = list_next(e))
-	{
-		t = list_entry(e, struct thread, elem);
-		mlfqs_recent_cpu(t);
-	}
+	struct cpu *c = this_cpu();
+	int budget = MLFQS_REFRESH_BATCH;
+
+	ASSERT(intr_get_level() == INTR_OFF);
 
-	for (e = list_begin(&sleep_list); e != list_end(&sleep_list); e = list_next(e))
+	while (budget > 0 && c->refresh_pri >= PRI_MIN)
 	{
-		t = list_entry(e, struct thread, elem);
-		mlfqs_recent_cpu(t);
-	}
+		int pri = c->refresh_pri;
+		struct list *rq = &c->ready_list[pri];
+		struct thread *t;
 
-	// running thread의 값도 갱신
-	mlfqs_recent_cpu(thread_current());
+		if (list_empty(rq))
+		{
+			c->refresh_pri--;
+			continue;
+		}
+		t = list_entry(list_front(rq), struct thread, elem);
+		if (t->recent_cpu_epoch == mlfqs_epoch)
+		{
+			c->refresh_pri--;
+			continue;
+		}
 
-	return;
-}
\ No newline at end of file
+		/* 우선순위가 바뀌면 mlfqs_priority()가 새 level의 맨 뒤로 옮긴다.
+		 * 그대로라면 같은 level의 맨 뒤로 직접 옮긴다. */
+		mlfqs_recent_cpu(t);
+		mlfqs_priority(t);
+		if (t->priority == pri)
+		{
+			spin_lock(&c->rq_lock);
+			list_remove(&t->elem);
+			list_push_back(rq, &t->elem);
+			spin_unlock(&c->rq_lock);
+		}
+		budget--;
+	}
+}
@@ -210,10 +210,14 @@ __do_fork(void *aux)
 	if (parent->fdIdx == FDCOUNT_LIMIT)
 		goto error;
 
+	/* 부모의 fd 테이블 크기에 맞춰 자식 테이블 확장 */
+	if (!thread_fdt_grow(current, parent->fdCap - 1))
+		goto error;
+
 	current->fdTable[0] = parent->fdTable[0]; // stdin
 	current->fdTable[1] = parent->fdTable[1]; // stdout
 
-	for (int i = 2; i < FDCOUNT_LIMIT; i++)
+	for (int i = 2; i < parent->fdCap; i++)
 	{
 		struct file *f = parent->fdTable[i];
 		if (f == NULL)
@@ -414,14 +418,20 @@ int process_wait(tid_t child_tid UNUSED)
 	if (!child)
 		return -1;
 
+	/* 자식은 free_sema에서 부모를 기다리므로 부모가 owner가 된다 */
+	sema_set_owner(&child->free_sema, thread_current());
+
 	/* 자식 프로세스가 종료할때 까지 대기 */
 	sema_down(&child->wait_sema);
 
 	/* 자식으로부터 종료인자를 전달 받고 리스트에서 삭제 */
 	int exit_status = child->exit_status;
 	list_remove(&child->child_elem);
+	child->parent_tid = TID_ERROR; // 같은 자식을 두 번 wait 할 수 없음
 
-	/* 자식 프로세스 종료 상태인자 받은 후 자식 프로세스 종료하게 함 */
+	/* 자식 프로세스 종료 상태인자 받은 후 자식 프로세스 종료하게 함
+	 * 자식의 struct thread가 해제되기 전에 owner 등록을 먼저 해제 */
+	sema_set_owner(&child->free_sema, NULL);
 	sema_up(&child->free_sema);
 
 	return exit_status;
@@ -437,13 +447,13 @@ void process_exit(void)
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
 	// 프로세스 종료가 일어날 경우 열려있는 모든 파일을 닫음
-	for (int i = 0; i < FDCOUNT_LIMIT; i++)
+	for (int i = 0; i < curr->fdCap; i++)
 	{
 		close(i);
 	}
 
-	/* thread_create에서 할당한 페이지 할당 해제 */
-	palloc_free_multiple(curr->fdTable, FDT_PAGES);
+	/* thread_create에서 할당한 fdTable 페이지는 스레드 페이지와 함께
+	 * reaper 스레드가 해제한다. */
 
 	/* 현재 프로세스가 실행중인 파일 종료 */
 	file_close(curr->running);
@@ -892,7 +902,7 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		struct segment *segment = malloc(sizeof(struct segment));
+		struct segment *segment = kmem_cache_alloc(segment_slab);
 		segment->ofs = ofs;
 		segment->read_bytes = page_read_bytes;
 		segment->zero_bytes = page_zero_bytes;
@@ -948,23 +958,15 @@ bool setup_stack(struct intr_frame *if_)
 #endif /* VM */
 
 /* get_child_process()
- * 현재 프로세스의 자식 리스트를 검색하여 해당 pid에 맞는 프로세스 디스크립터를 반환
+ * tid 해시에서 pid에 해당하는 스레드를 찾아, 현재 프로세스의 자식이면 반환
  * pid를 갖는 프로세스 디스크립터가 존재하지 않을 경우 NULL 반환
  */
 struct thread *get_child_process(int pid)
 {
 	struct thread *cur = thread_current();
-	struct list *child_list = &cur->child_list;
+	struct thread *t = thread_by_tid(pid);
 
-#ifdef DEBUG_WAIT
-	printf("\nparent children # : %d\n", list_size(child_list));
-#endif
-
-	for (struct list_elem *e = list_begin(child_list); e != list_end(child_list); e = list_next(e))
-	{
-		struct thread *t = list_entry(e, struct thread, child_elem);
-		if (t->tid == pid)
-			return t;
-	}
-	return NULL;
+	if (t == NULL || t->parent_tid != cur->tid)
+		return NULL;
+	return t;
 }
\ No newline at end of file
@@ -44,6 +44,9 @@ static struct file *find_file_by_fd(int fd);
 int add_file_to_fdt(struct file *file);
 void remove_file_from_fdt(int fd);
 
+/* 파일 시스템 접근 상호배제 (syscall.h 참고) */
+struct rwlock file_rw_lock;
+
 /* Project2-extra */
 const int STDIN = 1;
 const int STDOUT = 2;
@@ -75,7 +78,7 @@ void syscall_init(void)
 
 	// lock 초기화
 	// 각 시스템 콜에서 lock 획득 후 시스템 콜 처리, 시스템 콜 완료 시 lock 반납
-	lock_init(&file_rw_lock);
+	rw_init(&file_rw_lock);
 }
 
 /* The main system call interface */
@@ -177,7 +180,7 @@ static struct file *find_file_by_fd(int fd)
 
 	// Error - invalid id
 	// 해당 테이블에 파일 객체가 없을 시 NULL 반환
-	if (fd < 0 || fd >= FDCOUNT_LIMIT)
+	if (fd < 0 || fd >= cur->fdCap)
 		return NULL;
 
 	return cur->fdTable[fd];
@@ -196,15 +199,15 @@ int add_file_to_fdt(struct file *file)
 	 * 최대로 열 수 있는 파일 제한(FDCOUNT_LIMIT)을 넘지 않고,
 	 * 해당 fd에 이미 열려있는 파일이 있다면 1씩 증가한다.
 	 */
-	while (cur->fdIdx < FDCOUNT_LIMIT && fdt[cur->fdIdx])
+	while (cur->fdIdx < cur->fdCap && fdt[cur->fdIdx])
 		cur->fdIdx++;
 
-	// Error - fdt full
-	if (cur->fdIdx >= FDCOUNT_LIMIT)
+	// 할당된 테이블이 가득 찼으면 확장, Error - fdt full
+	if (!thread_fdt_grow(cur, cur->fdIdx))
 		return -1;
 
 	// 가용한 fd로 fdt[fd] 에 인자로 받은 file을 넣는다.
-	fdt[cur->fdIdx] = file;
+	cur->fdTable[cur->fdIdx] = file;
 	// 추가된 파일 객체의 File Descriptor 반환
 	return cur->fdIdx;
 }
@@ -217,7 +220,7 @@ void remove_file_from_fdt(int fd)
 	struct thread *cur = thread_current();
 
 	// Error - invalid fd
-	if (fd < 0 || fd >= FDCOUNT_LIMIT)
+	if (fd < 0 || fd >= cur->fdCap)
 		return;
 
 	cur->fdTable[fd] = NULL;
@@ -266,19 +269,22 @@ bool remove(const char *file)
 int open(const char *file)
 {
 	check_address(file);
-	lock_acquire(&file_rw_lock);
+	rw_write_acquire(&file_rw_lock);
 	// 해당 파일의 이름으로 열고, 해당 파일의 객체를 리턴한다.
 	struct file *fileobj = filesys_open(file);
 
 	if (fileobj == NULL)
+	{
+		rw_write_release(&file_rw_lock);
 		return -1;
+	}
 	// 서로 만든  파일을 현재 스레드의 파일디스크립터 테이블에 추가하고 해당 fd를 리턴한다.
 	int fd = add_file_to_fdt(fileobj);
 	/* 파일 디스크립터가 가득찬 경우 */
 	if (fd == -1)
 		file_close(fileobj);
 
-	lock_release(&file_rw_lock);
+	rw_write_release(&file_rw_lock);
 	// 해당 파일의 디스크립터를 리턴
 	return fd;
 }
@@ -349,9 +355,9 @@ int write(int fd, const void *buffer, unsigned size)
 	}
 	else
 	{
-		lock_acquire(&file_rw_lock);
+		rw_write_acquire(&file_rw_lock);
 		ret = file_write(fileobj, buffer, size);
-		lock_release(&file_rw_lock);
+		rw_write_release(&file_rw_lock);
 	}
 
 	return ret;
@@ -409,9 +415,9 @@ int read(int fd, void *buffer, unsigned size)
 	}
 	else
 	{
-		lock_acquire(&file_rw_lock);
+		rw_read_acquire(&file_rw_lock);
 		ret = file_read(fileobj, buffer, size);
-		lock_release(&file_rw_lock);
+		rw_read_release(&file_rw_lock);
 	}
 	return ret;
 }
@@ -501,7 +507,10 @@ int dup2(int oldfd, int newfd)
 		return -1;
 
 	struct thread *cur = thread_current();
-	struct file **fdt = cur->fdTable;
+
+	// newfd가 범위를 벗어나거나 테이블을 확장할 수 없으면 실패
+	if (newfd < 0 || !thread_fdt_grow(cur, newfd))
+		return -1;
 
 	// Don't literally copy, but just increase its count and share the same struct file
 	// [syscall close] Only close it when count == 0
@@ -515,7 +524,7 @@ int dup2(int oldfd, int newfd)
 		fileobj->dupCount++;
 
 	close(newfd);
-	fdt[newfd] = fileobj;
+	cur->fdTable[newfd] = fileobj;
 	return newfd;
 }
 // /* buffer를 사용하는 read() system call의 경우 buffer의 주소가 유효한 가상주소인지 아닌지 검사할 필요성이 있음
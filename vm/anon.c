@@ -62,5 +62,5 @@ anon_destroy(struct page *page)
 	struct frame *frame = page->frame;
 
 	list_remove(&frame->f_elem);
-	free(frame);
+	kmem_cache_free(frame_slab, frame);
 }
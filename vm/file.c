@@ -97,7 +97,7 @@ do_mmap(void *addr, size_t length, int writable,
 		size_t page_read_bytes = length < PGSIZE ? length : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-		struct segment *segment = malloc(sizeof(struct segment));
+		struct segment *segment = kmem_cache_alloc(segment_slab);
 		segment->ofs = offset;
 		segment->read_bytes = page_read_bytes;
 		segment->zero_bytes = page_zero_bytes;
@@ -136,7 +136,7 @@ lazy_load_file(struct page *page, void *aux)
 	uint32_t page_read_bytes = aux_data->read_bytes;
 	uint32_t page_zero_bytes = aux_data->zero_bytes;
 	//struct file_page에 넣어두기
-	page->file.file_aux = (struct segment*)malloc(sizeof(struct segment));
+	page->file.file_aux = kmem_cache_alloc(segment_slab);
 	memcpy(page->file.file_aux, aux_data, sizeof(struct segment));
 	// &page->file.target_file = f;
 	// page->file.page_ofs = ofs;
@@ -10,6 +10,9 @@
 
 struct list frame_table;
 struct list_elem *clock_pointer;
+struct kmem_cache *page_slab;
+struct kmem_cache *frame_slab;
+struct kmem_cache *segment_slab;
 static void vm_stack_growth(void *rsp, void *addr UNUSED);
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -25,6 +28,12 @@ void vm_init(void)
 	/* TODO: Your code goes here. */
 	list_init(&frame_table);
 	clock_pointer = list_begin(&frame_table);
+	/* SPT 항목이 많은 프로세스를 위해 정확한 크기의 slab cache 사용 */
+	page_slab = kmem_cache_create("page", sizeof(struct page), NULL);
+	frame_slab = kmem_cache_create("frame", sizeof(struct frame), NULL);
+	segment_slab = kmem_cache_create("segment", sizeof(struct segment), NULL);
+	if (page_slab == NULL || frame_slab == NULL || segment_slab == NULL)
+		PANIC("vm_init: cannot create object caches");
 	/* -------------------------- */
 }
 
@@ -68,7 +77,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		 * TODO: and then create "uninit" page struct by calling uninit_new. You
 		 * TODO: should modify the field after calling the uninit_new. */
 
-		page = (struct page *)malloc(sizeof(struct page));
+		page = kmem_cache_alloc(page_slab);
 		if (!page) return false;
 		bool (*initializer)(struct page *, enum vm_type, void *);
 
@@ -90,9 +99,12 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		page->writable = writable;
 
 		/* TODO: Insert the page into the spt. */
-		return spt_insert_page(spt, page) ? true : false;
+		if (!spt_insert_page(spt, page))
+			goto err;
+		return true;
 	}
 err:
+	kmem_cache_free(page_slab, page);
 	return false;
 }
 
@@ -212,7 +224,7 @@ static struct frame * // 여기서 얻은 frame을 담을 frame page table을 
 vm_get_frame(void)
 {
 
-	struct frame *frame = (struct frame *)malloc(sizeof(struct frame));
+	struct frame *frame = kmem_cache_alloc(frame_slab);
 
 	if (frame != NULL)
 	{
@@ -353,7 +365,7 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 		// 이렇게 해도 되나 ? -> ok: current thread == dst (child)
 		if (p->operations->type == VM_UNINIT)
 		{ // 초기 페이지
-			struct segment *aux = malloc(sizeof(struct segment));
+			struct segment *aux = kmem_cache_alloc(segment_slab);
 			memcpy(aux, p->uninit.aux, sizeof(struct segment)); // copy aux
 			if (!vm_alloc_page_with_initializer(page_get_type(p), p->va, p->writable, p->uninit.init, aux))
 			{
@@ -364,7 +376,7 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 		else if (p->operations->type == VM_FILE) //이미 file-backed로 초기화된 페이지들
 		{
 			//printf("copying spt!!\n");
-			struct segment *aux = (struct segment *)malloc(sizeof(struct segment));
+			struct segment *aux = kmem_cache_alloc(segment_slab);
 			memcpy(aux, p->file.file_aux, sizeof(struct segment));
 			//memcpy(aux, p->uninit.aux, sizeof(struct segment)); // copy aux
 			if (!vm_alloc_page_with_initializer(page_get_type(p), p->va, p->writable, lazy_load_file, aux))